@@ -9,17 +9,19 @@ the different string-matching algorithms implemented in this project.
 
 It performs the following steps:
 1.  Ensures the project is compiled by running 'make'.
-2.  Finds all .pcap test files in the 'data/tests/pcaps/' directory.
-3.  For each test file, it runs the './bin/testParse' executable with each
-    of the available algorithms:
+2.  Finds all .pcap / .pcapng test files in the 'data/tests/pcaps/' directory.
+3.  It runs the './bin/testParse' executable once over that directory with
+    each of the available algorithms, so the rules are parsed and the
+    engine is built once per algorithm rather than once per file:
     - Aho-Corasick ('a')
+    - Aho-Corasick, full DFA ('f')
     - Set-Horspool ('h')
     - Wu-Manber (Deterministic, 'd')
     - Wu-Manber (Probabilistic, 'p')
 4.  It captures and parses the statistical output from each run.
 5.  It measures the CPU time consumed by each algorithm during its run.
 6.  Finally, it presents a formatted comparison table in the
-    terminal for each test file.
+    terminal for each test file and one for the totals over all files.
 
 Dependencies:
 - psutil: For measuring CPU usage (`pip install psutil`)
@@ -67,6 +69,9 @@ PCAP_DIR = PROJECT_ROOT / "data" / "tests" / "pcaps"
 
 ALGORITHMS = {
     "a": "Aho-Corasick",
+    "f": "Aho-Corasick (DFA)",
+    "s": "Aho-Corasick (Hybrid)",
+    "c": "Aho-Corasick (Double-Array)",
     "h": "Set-Horspool",
     "d": "Wu-Manber (Det)",
     "p": "Wu-Manber (Prob)",
@@ -134,7 +139,7 @@ def find_pcap_files():
         console.print(f"[bold red]Error:[/bold red] Directory not found: {PCAP_DIR}")
         sys.exit(1)
 
-    pcap_files = sorted(list(PCAP_DIR.rglob("*.pcap")))
+    pcap_files = sorted(list(PCAP_DIR.rglob("*.pcap")) + list(PCAP_DIR.rglob("*.pcapng")))
 
     if not pcap_files:
         console.print(f"[bold red]Warning:[/bold red] No .pcap files found in {PCAP_DIR}.")
@@ -184,10 +189,38 @@ def parse_stats(output):
     return stats
 
 
-def run_analysis(pcap_file):
-    """Runs all algorithms on a single pcap file and returns the results."""
+SECTION_HEADER = re.compile(r"^=== (?:Scanning \(.*?\): (?P<file>.+)|Aggregate \(.*?\): \d+ files) ===$", re.M)
+GLOBAL_STATS = ("Preprocessing-Time", "Ruleset-Count", "Ruleset-Avg-Length", "Memory-Usage-MB")
+
+
+def split_sections(output):
+    """Splits a directory run into per-file sections and the aggregate section.
+
+    Returns ({file path: section text}, aggregate text or None).
+    """
+    files = {}
+    aggregate = None
+    headers = list(SECTION_HEADER.finditer(output))
+    for i, header in enumerate(headers):
+        end = headers[i + 1].start() if i + 1 < len(headers) else len(output)
+        body = output[header.end():end]
+        if header.group("file"):
+            files[header.group("file")] = body
+        else:
+            aggregate = body
+    return files, aggregate
+
+
+def run_analysis(pcap_dir):
+    """Runs each algorithm once over the whole pcap directory.
+
+    The engine is built once per algorithm and shared by every file, so
+    rule parsing and table construction are not repeated per pcap.
+    Returns ({pcap path: [per-algorithm stats]}, [aggregate stats]).
+    """
     console = Console()
-    results = []
+    per_file = {}
+    aggregates = []
 
     if not EXECUTABLE_PATH.exists():
         console.print(f"[bold red]Error:[/bold red] Executable not found at {EXECUTABLE_PATH}.")
@@ -197,43 +230,51 @@ def run_analysis(pcap_file):
     for key, name in ALGORITHMS.items():
         try:
             process = subprocess.run(
-                [str(EXECUTABLE_PATH), key, str(pcap_file)],
+                [str(EXECUTABLE_PATH), key, str(pcap_dir)],
                 capture_output=True,
                 text=True,
                 check=True,
                 cwd=PROJECT_ROOT,
             )
-
-            if process.returncode != 0:
-                console.print(f"  [dim]Skipping [yellow]{name}[/yellow] due to runtime error.[/dim]")
-                console.print(f"  [dim red]{process.stderr.strip()}[/dim red]")
-                continue
-
-            stats = parse_stats(process.stdout)
-            stats["Algorithm"] = name
-            results.append(stats)
-
         except FileNotFoundError:
             console.print(f"[bold red]Error:[/bold red] Executable not found: {EXECUTABLE_PATH}")
             sys.exit(1)
         except subprocess.CalledProcessError as e:
-            console.print(f"  [dim]Skipping [yellow]{name}[/yellow] due to runtime error on {pcap_file.name}.[/dim]")
+            console.print(f"  [dim]Skipping [yellow]{name}[/yellow] due to runtime error.[/dim]")
             console.print(f"  [dim red]{e.stderr.strip()}[/dim red]")
             continue
         except Exception as e:
-            console.print(f"An unexpected error occurred with {name} on {pcap_file.name}: {e}")
+            console.print(f"An unexpected error occurred with {name}: {e}")
+            continue
+
+        # Ruleset, preprocessing and memory lines are printed once per run
+        run_stats = parse_stats(process.stdout)
+        shared = {k: v for k, v in run_stats.items() if k in GLOBAL_STATS}
+
+        files, aggregate = split_sections(process.stdout)
+        for path, body in files.items():
+            stats = parse_stats(body)
+            stats.update(shared)
+            stats["Algorithm"] = name
+            per_file.setdefault(Path(path), []).append(stats)
 
-    return results
+        if aggregate is not None:
+            stats = parse_stats(aggregate)
+            stats.update(shared)
+            stats["Algorithm"] = name
+            aggregates.append(stats)
+
+    return per_file, aggregates
 
 
-def display_results(pcap_file, results):
-    """Displays the results for a single pcap file in a beautiful table."""
+def display_results(title, results):
+    """Displays the results for a single pcap file (or the aggregate) in a beautiful table."""
     if not results:
         return
 
     console = Console()
     table = Table(
-        title=f"Analysis for [bold magenta]{pcap_file.name}[/bold magenta]",
+        title=f"Analysis for [bold magenta]{title}[/bold magenta]",
         show_header=True,
         header_style="bold cyan",
     )
@@ -283,7 +324,8 @@ def generate_plots(all_results):
             return default
 
     # Separate algorithms into two groups: fast and slow
-    fast_algs = ['Aho-Corasick', 'Wu-Manber (Det)', 'Wu-Manber (Prob)']
+    fast_algs = ['Aho-Corasick', 'Aho-Corasick (DFA)', 'Aho-Corasick (Hybrid)',
+                 'Aho-Corasick (Double-Array)', 'Wu-Manber (Det)', 'Wu-Manber (Prob)']
     slow_algs = ['Set-Horspool', 'Boyer-Moore']
 
     fast_names = [name for name in alg_names if name in fast_algs]
@@ -403,16 +445,22 @@ def main():
     compile_project()
     pcap_files = find_pcap_files()
 
-    console.print("[bold cyan]Step 3: Running analysis on each .pcap file...[/bold cyan]\n")
+    console.print("[bold cyan]Step 3: Running each algorithm over the capture directory...[/bold cyan]\n")
+
+    per_file, aggregates = run_analysis(PCAP_DIR)
 
     # We'll collect results from the first pcap file to use for plotting
     first_pcap_results = None
 
     for pcap_file in pcap_files:
-        results = run_analysis(pcap_file)
-        if results and not first_pcap_results:
+        results = per_file.get(pcap_file)
+        if not results:
+            continue
+        if not first_pcap_results:
             first_pcap_results = results
-        display_results(pcap_file, results)
+        display_results(pcap_file.name, results)
+
+    display_results(f"all {len(per_file)} captures", aggregates)
 
     # Generate plots based on the first valid set of results
     if first_pcap_results:
@@ -3,8 +3,8 @@
  *
  * ---------------------------------------------------------------
  * Implements the Aho–Corasick string matching algorithm for
- * multiple pattern searches. Supports case-insensitive matching
- * for ASCII text.
+ * multiple pattern searches. Supports a mix of case-insensitive
+ * (Snort nocase) and case-sensitive patterns over ASCII text.
  *
  * Reference:
  *   A. V. Aho, M. J. Corasick,
@@ -22,10 +22,52 @@
 #include "../../parse/analytics.h"
 
 /* ---------------------------------------------------------------
- *     Convert a character to lowercase (for case-insensitive)
+ *   Growable list of state ids used by the incremental updates
  * --------------------------------------------------------------- */
-static inline unsigned char to_lower_char(unsigned char c) {
-    return (unsigned char)tolower(c);
+typedef struct {
+    int *items;
+    int  count;
+    int  cap;
+} StateList;
+
+static void state_list_push(StateList *l, int state) {
+    if (l->count == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 64;
+        l->items = track_realloc(l->items, (size_t)l->cap * sizeof(int));
+        if (!l->items) {
+            fprintf(stderr, "Failed to reallocate state list\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    l->items[l->count++] = state;
+}
+
+/* ---------------------------------------------------------------
+ *   Trie row of state: its child on each byte class, or -1
+ * --------------------------------------------------------------- */
+static inline int *ac_row(const AhoCorasick *ac, int state) {
+    return ac->trie + (size_t)state * (size_t)ac->class_count;
+}
+
+/* ---------------------------------------------------------------
+ *   Reset node `state` to a childless leaf below parent
+ * --------------------------------------------------------------- */
+static void ac_init_node(AhoCorasick *ac, int state, int parent) {
+    ACNode *node = &ac->nodes[state];
+    node->fail_state = 0;
+    node->dict_link = -1;
+    node->output_head = -1;
+    node->output_count = 0;
+    node->parent = parent;
+    node->depth = parent == -1 ? 0 : ac->nodes[parent].depth + 1;
+    node->child_count = 0;
+    node->fail_children = NULL;
+    node->fail_child_count = 0;
+    node->fail_child_cap = 0;
+
+    int *row = ac_row(ac, state);
+    for (int k = 0; k < ac->class_count; k++)
+        row[k] = -1;
 }
 
 /* ---------------------------------------------------------------
@@ -38,157 +80,1168 @@ AhoCorasick *ac_create(void) {
         exit(EXIT_FAILURE);
     }
 
+    // Every byte starts in class 0, which has no transitions
+    for (int i = 0; i < 256; i++) {
+        ac->fold[i] = (unsigned char)tolower(i);
+        ac->byte_class[i] = 0;
+    }
+    ac->class_count = 1;
+
     ac->capacity = 8;
     ac->nodes = track_malloc((size_t)ac->capacity * sizeof(ACNode));
-    if (!ac->nodes) {
+    ac->trie = track_malloc((size_t)ac->capacity * sizeof(int));
+    if (!ac->nodes || !ac->trie) {
         fprintf(stderr, "Memory allocation failed for trie nodes\n");
         exit(EXIT_FAILURE);
     }
+    ac_init_node(ac, 0, -1);
+    ac->node_count = 1;
 
-    for (int i = 0; i < 256; i++)
-        ac->nodes[0].transitions[i] = -1;
+    ac->patterns = NULL;
+    ac->pattern_count = 0;
+    ac->pattern_capacity = 0;
+    ac->free_list = -1;
+    ac->built = 0;
 
-    ac->nodes[0].fail_state = 0;
-    ac->nodes[0].output = NULL;
-    ac->nodes[0].output_count = 0;
-    ac->node_count = 1;
+    ac->layout = AC_LAYOUT_NFA;
+    ac->frozen = 0;
+    ac->out_start = NULL;
+    ac->out_ids = NULL;
+    ac->match_state = NULL;
+    ac->dfa16 = NULL;
+    ac->dfa32 = NULL;
+    ac->hyb_index = NULL;
+    ac->hyb_dense = NULL;
+    ac->hyb_sparse = NULL;
+    ac->hyb_child = NULL;
+    ac->hyb_dense_count = 0;
+    ac->hyb_sparse_count = 0;
+    ac->hyb_child_count = 0;
+    ac->da_base = NULL;
+    ac->da_check = NULL;
+    ac->da_fail = NULL;
+    ac->da_match = NULL;
+    ac->da_size = 0;
 
     return ac;
 }
 
 /* ---------------------------------------------------------------
- *          Insert a pattern string into the automaton
+ *   Class of folded byte c, giving it a class of its own if it
+ *   is still in the shared class 0. The new class starts as a copy
+ *   of class 0's column, which is what c led to until now; rows
+ *   are moved up to their new width from the last one down.
  * --------------------------------------------------------------- */
-void ac_add_pattern(AhoCorasick *ac, const char *pattern) {
-    if (!ac || !pattern || !*pattern) return;
+static int ac_assign_class(AhoCorasick *ac, unsigned char c) {
+    if (ac->byte_class[c] != 0) return ac->byte_class[c];
 
-    int state = 0;
-    for (int i = 0; pattern[i] != '\0'; i++) {
-        unsigned char c = to_lower_char((unsigned char)pattern[i]);
-        if (ac->nodes[state].transitions[c] == -1) {
-            if (ac->node_count >= ac->capacity) {
-                ac->capacity *= 2;
-                ac->nodes = track_realloc(ac->nodes, (size_t)ac->capacity * sizeof(ACNode));
-                if (!ac->nodes) {
-                    fprintf(stderr, "Failed to reallocate trie nodes\n");
-                    exit(EXIT_FAILURE);
-                }
+    size_t old_w = (size_t)ac->class_count;
+    size_t new_w = old_w + 1;
+    ac->trie = track_realloc(ac->trie, (size_t)ac->capacity * new_w * sizeof(int));
+    if (!ac->trie) {
+        fprintf(stderr, "Failed to reallocate trie rows\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t st = (size_t)ac->node_count; st-- > 0;) {
+        memmove(ac->trie + st * new_w, ac->trie + st * old_w, old_w * sizeof(int));
+        ac->trie[st * new_w + old_w] = ac->trie[st * new_w];
+    }
+
+    int k = ac->class_count++;
+    for (int b = 0; b < 256; b++)
+        if (ac->fold[b] == c) ac->byte_class[b] = (unsigned char)k;
+    return k;
+}
+
+/* ---------------------------------------------------------------
+ *   Child of state on byte class k, or -1. Once built, missing
+ *   root transitions loop back to the root (0).
+ * --------------------------------------------------------------- */
+static int ac_child(const AhoCorasick *ac, int state, int k) {
+    int next = ac_row(ac, state)[k];
+    return (state == 0 && next == 0) ? -1 : next;
+}
+
+/* ---------------------------------------------------------------
+ *   Create the child of parent on byte class k, reusing a freed
+ *   node when one is available
+ * --------------------------------------------------------------- */
+static int ac_new_node(AhoCorasick *ac, int parent, int k) {
+    int state;
+    if (ac->free_list != -1) {
+        state = ac->free_list;
+        ac->free_list = ac->nodes[state].parent;
+    } else {
+        if (ac->node_count >= ac->capacity) {
+            ac->capacity *= 2;
+            ac->nodes = track_realloc(ac->nodes, (size_t)ac->capacity * sizeof(ACNode));
+            ac->trie = track_realloc(ac->trie, (size_t)ac->capacity *
+                                     (size_t)ac->class_count * sizeof(int));
+            if (!ac->nodes || !ac->trie) {
+                fprintf(stderr, "Failed to reallocate trie nodes\n");
+                exit(EXIT_FAILURE);
             }
+        }
+        state = ac->node_count++;
+    }
 
-            int new_state = ac->node_count++;
-            for (int j = 0; j < 256; j++)
-                ac->nodes[new_state].transitions[j] = -1;
+    ac_init_node(ac, state, parent);
+    ac_row(ac, parent)[k] = state;
+    ac->nodes[parent].child_count++;
+    return state;
+}
 
-            ac->nodes[new_state].fail_state = 0;
-            ac->nodes[new_state].output = NULL;
-            ac->nodes[new_state].output_count = 0;
+/* ---------------------------------------------------------------
+ *   Point state's failure link at fail and record the reverse link
+ * --------------------------------------------------------------- */
+static void ac_link_fail(AhoCorasick *ac, int state, int fail) {
+    ac->nodes[state].fail_state = fail;
 
-            ac->nodes[state].transitions[c] = new_state;
+    ACNode *f = &ac->nodes[fail];
+    if (f->fail_child_count == f->fail_child_cap) {
+        f->fail_child_cap = f->fail_child_cap ? f->fail_child_cap * 2 : 4;
+        f->fail_children = track_realloc(f->fail_children,
+            (size_t)f->fail_child_cap * sizeof(int));
+        if (!f->fail_children) {
+            fprintf(stderr, "Failed to reallocate failure links\n");
+            exit(EXIT_FAILURE);
         }
-        state = ac->nodes[state].transitions[c];
     }
+    f->fail_children[f->fail_child_count++] = state;
+}
 
+/* ---------------------------------------------------------------
+ *   Drop state from the reverse links of its failure state
+ * --------------------------------------------------------------- */
+static void ac_unlink_fail(AhoCorasick *ac, int state) {
+    ACNode *f = &ac->nodes[ac->nodes[state].fail_state];
+    for (int i = 0; i < f->fail_child_count; i++) {
+        if (f->fail_children[i] == state) {
+            f->fail_children[i] = f->fail_children[--f->fail_child_count];
+            return;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Dictionary link implied by a failure link to fail
+ * --------------------------------------------------------------- */
+static int ac_dict_from(const AhoCorasick *ac, int fail) {
+    return ac->nodes[fail].output_count > 0 ? fail : ac->nodes[fail].dict_link;
+}
+
+/* ---------------------------------------------------------------
+ *   Register pattern bytes and return the new pattern id
+ * --------------------------------------------------------------- */
+static int ac_register_pattern(AhoCorasick *ac, const char *pattern, size_t len,
+                               int nocase) {
+    if (ac->pattern_count >= ac->pattern_capacity) {
+        ac->pattern_capacity = ac->pattern_capacity ? ac->pattern_capacity * 2 : 64;
+        ac->patterns = track_realloc(ac->patterns,
+            (size_t)ac->pattern_capacity * sizeof(ACPattern));
+        if (!ac->patterns) {
+            fprintf(stderr, "Failed to reallocate pattern table\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    int pid = ac->pattern_count++;
+    ac->patterns[pid].bytes = (const unsigned char *)pattern;
+    ac->patterns[pid].length = (int)len;
+    ac->patterns[pid].nocase = nocase;
+    ac->patterns[pid].next_output = -1;
+    return pid;
+}
+
+/* ---------------------------------------------------------------
+ *    Append pattern id pid to the end of state's output chain
+ * --------------------------------------------------------------- */
+static void ac_add_output(AhoCorasick *ac, int state, int pid) {
     ACNode *node = &ac->nodes[state];
-    node->output = track_realloc(node->output, (size_t)(node->output_count + 1) * sizeof(char *));
-    node->output[node->output_count] = (char *)pattern;
+    int *link = &node->output_head;
+    while (*link != -1)
+        link = &ac->patterns[*link].next_output;
+    *link = pid;
+    ac->patterns[pid].next_output = -1;
     node->output_count++;
 }
 
 /* ---------------------------------------------------------------
- *   Compute failure links using BFS traversal and merge outputs
+ *   Set the dictionary link of every state below `state` in the
+ *   failure tree whose nearest output-bearing proper suffix is
+ *   `state` (i.e. with no output state in between) to dict
+ * --------------------------------------------------------------- */
+static void ac_relink_dict(AhoCorasick *ac, int state, int dict) {
+    StateList stack = {0};
+    state_list_push(&stack, state);
+    while (stack.count > 0) {
+        ACNode *node = &ac->nodes[stack.items[--stack.count]];
+        for (int i = 0; i < node->fail_child_count; i++) {
+            int child = node->fail_children[i];
+            ac->nodes[child].dict_link = dict;
+            if (ac->nodes[child].output_count == 0)
+                state_list_push(&stack, child);
+        }
+    }
+    track_free(stack.items);
+}
+
+/* ---------------------------------------------------------------
+ *   Link a state just added to a built automaton as the child of
+ *   parent on byte class c (label w = label(parent)·c):
+ *     - its own failure link is found as in ac_build
+ *     - any existing state v = x·c, with parent x below parent in
+ *       the failure tree, now has w as a longer proper suffix than
+ *       its current failure state and is re-pointed at the new
+ *       state. The search does not descend past states x that
+ *       already have a c child, since the states below them reach
+ *       a suffix longer than w through it.
+ *   Dictionary links are unaffected: the new state has no output
+ *   yet and inherits the one re-pointed states had.
+ * --------------------------------------------------------------- */
+static void ac_link_new_state(AhoCorasick *ac, int state, int parent, int c) {
+    int fail = 0;
+    if (parent != 0) {
+        int f = ac->nodes[parent].fail_state;
+        for (;;) {
+            int next = ac_child(ac, f, c);
+            if (next != -1) { fail = next; break; }
+            if (f == 0) break;
+            f = ac->nodes[f].fail_state;
+        }
+    }
+    ac_link_fail(ac, state, fail);
+    ac->nodes[state].dict_link = ac_dict_from(ac, fail);
+
+    // Collect first: re-pointing edits reverse-link lists
+    StateList stack = {0}, moved = {0};
+    state_list_push(&stack, parent);
+    while (stack.count > 0) {
+        ACNode *node = &ac->nodes[stack.items[--stack.count]];
+        for (int i = 0; i < node->fail_child_count; i++) {
+            int x = node->fail_children[i];
+            int v = ac_child(ac, x, c);
+            if (v == -1) {
+                state_list_push(&stack, x);
+            } else if (v != state &&
+                       ac->nodes[ac->nodes[v].fail_state].depth < ac->nodes[state].depth) {
+                state_list_push(&moved, v);
+            }
+        }
+    }
+
+    for (int i = 0; i < moved.count; i++) {
+        ac_unlink_fail(ac, moved.items[i]);
+        ac_link_fail(ac, moved.items[i], state);
+    }
+
+    track_free(stack.items);
+    track_free(moved.items);
+}
+
+/* ---------------------------------------------------------------
+ *   Walk pattern pid down the trie, creating its missing nodes
+ *   (and, on a built automaton, linking each new one), and return
+ *   the state it ends in. Its bytes must already have classes.
+ * --------------------------------------------------------------- */
+static int ac_insert_path(AhoCorasick *ac, int pid) {
+    const ACPattern *p = &ac->patterns[pid];
+    int state = 0;
+    for (int i = 0; i < p->length; i++) {
+        int k = ac->byte_class[p->bytes[i]];
+        int next = ac_child(ac, state, k);
+        if (next == -1) {
+            next = ac_new_node(ac, state, k);
+            if (ac->built) ac_link_new_state(ac, next, state, k);
+        }
+        state = next;
+    }
+    return state;
+}
+
+/* ---------------------------------------------------------------
+ *    Add a pattern of len raw bytes (may contain NULs). The
+ *    bytes are referenced, not copied. Case-sensitive patterns
+ *    share the folded trie path and are verified on match. Its
+ *    trie path is created by ac_build.
+ * --------------------------------------------------------------- */
+void ac_add_pattern(AhoCorasick *ac, const char *pattern, size_t len, int nocase) {
+    if (!ac || !pattern || len == 0) return;
+    if (ac->built) {
+        ac_insert_pattern(ac, pattern, len, nocase);
+        return;
+    }
+
+    ac_register_pattern(ac, pattern, len, nocase);
+}
+
+/* ---------------------------------------------------------------
+ *   Flatten the output chains into one id array, state by state,
+ *   with out_start[s] .. out_start[s + 1] the outputs of state s
+ * --------------------------------------------------------------- */
+static void ac_compile_outputs(AhoCorasick *ac) {
+    int total = 0;
+    for (int i = 0; i < ac->node_count; i++)
+        total += ac->nodes[i].output_count;
+
+    ac->out_start = track_malloc((size_t)(ac->node_count + 1) * sizeof(int));
+    ac->out_ids = track_malloc((total ? (size_t)total : 1) * sizeof(int));
+    if (!ac->out_start || !ac->out_ids) {
+        fprintf(stderr, "Memory allocation failed for output lists\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int next = 0;
+    for (int i = 0; i < ac->node_count; i++) {
+        ac->out_start[i] = next;
+        for (int pid = ac->nodes[i].output_head; pid != -1;
+             pid = ac->patterns[pid].next_output)
+            ac->out_ids[next++] = pid;
+    }
+    ac->out_start[ac->node_count] = next;
+}
+
+/* ---------------------------------------------------------------
+ *   Per state, the first output-bearing state on its dictionary
+ *   chain (itself if it has outputs), so compiled scans test one
+ *   array instead of the node
+ * --------------------------------------------------------------- */
+static void ac_compile_match(AhoCorasick *ac) {
+    ac->match_state = track_malloc((size_t)ac->node_count * sizeof(int));
+    if (!ac->match_state) {
+        fprintf(stderr, "Memory allocation failed for match states\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < ac->node_count; i++) {
+        const ACNode *node = &ac->nodes[i];
+        ac->match_state[i] = node->output_count > 0 ? i : node->dict_link;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Next state from `state` on class k with every miss resolved:
+ *   the child of the longest suffix state that has one, else root
+ * --------------------------------------------------------------- */
+static int ac_resolve(const AhoCorasick *ac, int state, int k) {
+    for (;;) {
+        int next = ac_child(ac, state, k);
+        if (next != -1) return next;
+        if (state == 0) return 0;
+        state = ac->nodes[state].fail_state;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Resolve every transition of the built trie into the DFA:
+ *     delta(s, k) = goto(s, k)            if s has a class-k child
+ *                 = delta(fail(s), k)     otherwise
+ *   Visiting states in BFS order means fail(s), being shallower,
+ *   already has its row. Nodes on the free list are unreachable
+ *   and keep zeroed rows. Entries carry the terminal bit of the
+ *   state they lead to, and are 16-bit whenever every id fits
+ *   beside it.
+ * --------------------------------------------------------------- */
+static void ac_compile_dfa(AhoCorasick *ac) {
+    size_t n = (size_t)ac->node_count;
+    size_t w = (size_t)ac->class_count;
+    if (n <= AC_DFA16_TERMINAL)
+        ac->dfa16 = track_calloc(n * w, sizeof(uint16_t));
+    else
+        ac->dfa32 = track_calloc(n * w, sizeof(uint32_t));
+    int *queue = track_malloc(n * sizeof(int));
+    if ((!ac->dfa16 && !ac->dfa32) || !queue) {
+        fprintf(stderr, "Memory allocation failed for DFA tables\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int front = 0, rear = 0;
+    queue[rear++] = 0;
+    while (front < rear) {
+        int state = queue[front++];
+        size_t row = (size_t)state * w;
+        size_t fail_row = (size_t)ac->nodes[state].fail_state * w;
+
+        for (size_t k = 0; k < w; k++) {
+            int child = ac_child(ac, state, (int)k);
+            uint32_t next;
+            if (child != -1) {
+                next = (uint32_t)child;
+                if (ac->match_state[child] != -1)
+                    next |= ac->dfa16 ? AC_DFA16_TERMINAL : AC_TERMINAL;
+                queue[rear++] = child;
+            } else if (state == 0) {
+                next = 0;
+            } else {
+                next = ac->dfa16 ? ac->dfa16[fail_row + k] : ac->dfa32[fail_row + k];
+            }
+            if (ac->dfa16) ac->dfa16[row + k] = (uint16_t)next;
+            else           ac->dfa32[row + k] = next;
+        }
+    }
+
+    track_free(queue);
+}
+
+/* ---------------------------------------------------------------
+ *   Split the states into dense rows and sparse nodes. Dense rows
+ *   are resolved like DFA rows, so a scan reaching one needs no
+ *   failure walk; the root is always dense row 0, which also
+ *   stands in for the unreachable states on the free list. Sparse
+ *   nodes list their trie children only. Dense and child words
+ *   carry terminal bits; failure links need none, since a scan
+ *   never stops on one.
+ * --------------------------------------------------------------- */
+static void ac_compile_hybrid(AhoCorasick *ac) {
+    size_t n = (size_t)ac->node_count;
+    size_t w = (size_t)ac->class_count;
+    ac->hyb_index = track_malloc(n * sizeof(uint32_t));
+    if (!ac->hyb_index) {
+        fprintf(stderr, "Memory allocation failed for hybrid index\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Free-list nodes are recognised by a parent that has no
+    // child leading back to them
+    int dense = 1, sparse = 0, children = 0;
+    ac->hyb_index[0] = AC_HYBRID_DENSE;
+    for (size_t i = 1; i < n; i++) {
+        const ACNode *node = &ac->nodes[i];
+        int live = 0;
+        if (node->parent >= 0) {
+            const int *prow = ac_row(ac, node->parent);
+            for (size_t k = 0; k < w && !live; k++)
+                live = prow[k] == (int)i;
+        }
+        if (!live) {
+            ac->hyb_index[i] = AC_HYBRID_DENSE;
+        } else if (node->depth < AC_HYBRID_DENSE_DEPTH ||
+                   node->child_count >= AC_HYBRID_DENSE_FANOUT) {
+            ac->hyb_index[i] = AC_HYBRID_DENSE | (uint32_t)dense++;
+        } else {
+            ac->hyb_index[i] = (uint32_t)sparse++;
+            children += node->child_count;
+        }
+    }
+
+    ac->hyb_dense = track_malloc((size_t)dense * w * sizeof(uint32_t));
+    ac->hyb_sparse = track_calloc(sparse ? (size_t)sparse : 1, sizeof(ACSparseNode));
+    ac->hyb_child = track_malloc((children ? (size_t)children : 1) * sizeof(uint32_t));
+    if (!ac->hyb_dense || !ac->hyb_sparse || !ac->hyb_child) {
+        fprintf(stderr, "Memory allocation failed for hybrid tables\n");
+        exit(EXIT_FAILURE);
+    }
+    ac->hyb_dense_count = dense;
+    ac->hyb_sparse_count = sparse;
+    ac->hyb_child_count = children;
+
+    uint32_t next_child = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t info = ac->hyb_index[i];
+        if (info & AC_HYBRID_DENSE) {
+            if (i > 0 && info == AC_HYBRID_DENSE) continue;  // unreachable
+            uint32_t *row = ac->hyb_dense + (size_t)(info & ~AC_HYBRID_DENSE) * w;
+            for (size_t k = 0; k < w; k++) {
+                int next = ac_resolve(ac, (int)i, (int)k);
+                row[k] = (uint32_t)next | (ac->match_state[next] != -1 ? AC_TERMINAL : 0);
+            }
+        } else {
+            ACSparseNode *sn = &ac->hyb_sparse[info];
+            sn->first_child = next_child;
+            sn->fail = (uint32_t)ac->nodes[i].fail_state;
+            for (size_t k = 0; k < w; k++) {
+                int child = ac_child(ac, (int)i, (int)k);
+                if (child == -1) continue;
+                sn->bitmap[k >> 6] |= 1ull << (k & 63);
+                ac->hyb_child[next_child++] = (uint32_t)child |
+                    (ac->match_state[child] != -1 ? AC_TERMINAL : 0);
+            }
+        }
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Grow the double-array tables to hold slot `need`, marking the
+ *   new slots free
+ * --------------------------------------------------------------- */
+static void ac_da_reserve(AhoCorasick *ac, int need) {
+    if (need < ac->da_size) return;
+    int size = ac->da_size ? ac->da_size : 256;
+    while (size <= need) size *= 2;
+
+    ac->da_base = track_realloc(ac->da_base, (size_t)size * sizeof(int));
+    ac->da_check = track_realloc(ac->da_check, (size_t)size * sizeof(uint32_t));
+    ac->da_fail = track_realloc(ac->da_fail, (size_t)size * sizeof(int));
+    ac->da_match = track_realloc(ac->da_match, (size_t)size * sizeof(int));
+    if (!ac->da_base || !ac->da_check || !ac->da_fail || !ac->da_match) {
+        fprintf(stderr, "Failed to reallocate double-array tables\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = ac->da_size; i < size; i++) {
+        ac->da_base[i] = 0;
+        ac->da_check[i] = AC_DA_FREE;
+        ac->da_fail[i] = 0;
+        ac->da_match[i] = -1;
+    }
+    ac->da_size = size;
+}
+
+/* ---------------------------------------------------------------
+ *   Pack the trie into a double array. States are placed in BFS
+ *   order; each parent gets the first base at which all of its
+ *   child slots are free (first fit). The root is slot 0. Leaves
+ *   keep base 0, which is safe since no slot names them in check.
+ *   The tables are then trimmed to the last used slot plus one row
+ *   of classes, so base + k never leaves them.
+ * --------------------------------------------------------------- */
+static void ac_compile_double_array(AhoCorasick *ac) {
+    size_t n = (size_t)ac->node_count;
+    int w = ac->class_count;
+    int *slot_of = track_malloc(n * sizeof(int));
+    int *queue = track_malloc(n * sizeof(int));
+    int *kids = track_malloc((size_t)w * sizeof(int));
+    if (!slot_of || !queue || !kids) {
+        fprintf(stderr, "Memory allocation failed for double-array build\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; i++) slot_of[i] = -1;
+
+    ac_da_reserve(ac, w);
+    ac->da_check[0] = 0;  // root: owned by itself, never free
+    slot_of[0] = 0;
+    int search_from = 1, last_used = 0;
+
+    int front = 0, rear = 0;
+    queue[rear++] = 0;
+    while (front < rear) {
+        int state = queue[front++];
+        int slot = slot_of[state];
+
+        int nkids = 0;
+        for (int k = 0; k < w; k++)
+            if (ac_child(ac, state, k) != -1) kids[nkids++] = k;
+        if (nkids == 0) continue;
+
+        // Candidate bases put the first child on a free slot; a
+        // prefix found nearly full is skipped by later searches
+        int pos = search_from, occupied = 0, base;
+        for (;; pos++) {
+            ac_da_reserve(ac, pos + w);
+            if (ac->da_check[pos] != AC_DA_FREE) {
+                occupied++;
+                continue;
+            }
+            base = pos - kids[0];
+            if (base < 1) continue;
+            int fits = 1;
+            for (int j = 1; j < nkids && fits; j++)
+                fits = ac->da_check[base + kids[j]] == AC_DA_FREE;
+            if (fits) break;
+        }
+        if (occupied * 20 >= (pos - search_from + 1) * 19) search_from = pos;
+
+        ac->da_base[slot] = base;
+        for (int j = 0; j < nkids; j++) {
+            int child = ac_child(ac, state, kids[j]);
+            int t = base + kids[j];
+            ac->da_check[t] = (uint32_t)slot;
+            slot_of[child] = t;
+            queue[rear++] = child;
+            if (t > last_used) last_used = t;
+        }
+    }
+
+    // Failure and output links, now that every live state has a
+    // slot; a terminal slot is marked in its own check word
+    for (int i = 0; i < rear; i++) {
+        const ACNode *node = &ac->nodes[queue[i]];
+        int slot = slot_of[queue[i]];
+        ac->da_fail[slot] = slot_of[node->fail_state];
+        ac->da_match[slot] = node->output_count > 0 ? queue[i] : node->dict_link;
+        if (ac->da_match[slot] != -1) ac->da_check[slot] |= AC_TERMINAL;
+    }
+
+    int size = last_used + w + 1;
+    if (size < ac->da_size) {
+        ac->da_base = track_realloc(ac->da_base, (size_t)size * sizeof(int));
+        ac->da_check = track_realloc(ac->da_check, (size_t)size * sizeof(uint32_t));
+        ac->da_fail = track_realloc(ac->da_fail, (size_t)size * sizeof(int));
+        ac->da_match = track_realloc(ac->da_match, (size_t)size * sizeof(int));
+        if (!ac->da_base || !ac->da_check || !ac->da_fail || !ac->da_match) {
+            fprintf(stderr, "Failed to reallocate double-array tables\n");
+            exit(EXIT_FAILURE);
+        }
+        ac->da_size = size;
+    }
+
+    track_free(kids);
+    track_free(queue);
+    track_free(slot_of);
+}
+
+/* ---------------------------------------------------------------
+ *   Release the compiled scan tables
+ * --------------------------------------------------------------- */
+static void ac_free_compiled(AhoCorasick *ac) {
+    track_free(ac->out_start);
+    track_free(ac->out_ids);
+    track_free(ac->match_state);
+    track_free(ac->dfa16);
+    track_free(ac->dfa32);
+    track_free(ac->hyb_index);
+    track_free(ac->hyb_dense);
+    track_free(ac->hyb_sparse);
+    track_free(ac->hyb_child);
+    ac->out_start = NULL;
+    ac->out_ids = NULL;
+    ac->match_state = NULL;
+    ac->dfa16 = NULL;
+    ac->dfa32 = NULL;
+    ac->hyb_index = NULL;
+    ac->hyb_dense = NULL;
+    ac->hyb_sparse = NULL;
+    ac->hyb_child = NULL;
+    ac->hyb_dense_count = 0;
+    ac->hyb_sparse_count = 0;
+    ac->hyb_child_count = 0;
+    track_free(ac->da_base);
+    track_free(ac->da_check);
+    track_free(ac->da_fail);
+    track_free(ac->da_match);
+    ac->da_base = NULL;
+    ac->da_check = NULL;
+    ac->da_fail = NULL;
+    ac->da_match = NULL;
+    ac->da_size = 0;
+}
+
+/* ---------------------------------------------------------------
+ *   (Re)build the scan tables of the selected layout from the
+ *   built trie
+ * --------------------------------------------------------------- */
+static void ac_compile(AhoCorasick *ac) {
+    ac_free_compiled(ac);
+    switch (ac->layout) {
+        case AC_LAYOUT_DFA:
+            ac_compile_outputs(ac);
+            ac_compile_match(ac);
+            ac_compile_dfa(ac);
+            break;
+        case AC_LAYOUT_HYBRID:
+            ac_compile_outputs(ac);
+            ac_compile_match(ac);
+            ac_compile_hybrid(ac);
+            break;
+        case AC_LAYOUT_DOUBLE_ARRAY:
+            ac_compile_outputs(ac);
+            ac_compile_double_array(ac);
+            break;
+        case AC_LAYOUT_NFA:
+        default:
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Choose the scan layout. Before ac_build this only records the
+ *   choice; on a built automaton the new layout is compiled now.
+ * --------------------------------------------------------------- */
+void ac_set_layout(AhoCorasick *ac, ACLayout layout) {
+    if (!ac || ac->frozen) return;
+    ac_free_compiled(ac);
+    ac->layout = layout;
+    if (ac->built) ac_compile(ac);
+}
+
+/* ---------------------------------------------------------------
+ *   Build the automaton: assign the byte classes of every pattern
+ *   added so far, grow the trie at its final row width, then
+ *   compute failure and dictionary links using BFS traversal
  * --------------------------------------------------------------- */
 void ac_build(AhoCorasick *ac) {
-    if (!ac) return;
+    if (!ac || ac->built) return;
+
+    for (int pid = 0; pid < ac->pattern_count; pid++) {
+        const ACPattern *p = &ac->patterns[pid];
+        for (int i = 0; i < p->length; i++)
+            ac_assign_class(ac, ac->fold[p->bytes[i]]);
+    }
+    for (int pid = 0; pid < ac->pattern_count; pid++) {
+        if (ac->patterns[pid].length == 0) continue;  // removed before the build
+        ac_add_output(ac, ac_insert_path(ac, pid), pid);
+    }
 
     int *queue = track_malloc((size_t)ac->node_count * sizeof(int));
+    if (!queue) {
+        fprintf(stderr, "Memory allocation failed for BFS queue\n");
+        exit(EXIT_FAILURE);
+    }
     int front = 0, rear = 0;
 
-    for (int c = 0; c < 256; c++) {
-        int next = ac->nodes[0].transitions[c];
+    int *root = ac_row(ac, 0);
+    for (int k = 0; k < ac->class_count; k++) {
+        int next = root[k];
         if (next != -1) {
-            ac->nodes[next].fail_state = 0;
+            ac_link_fail(ac, next, 0);
             queue[rear++] = next;
         } else {
-            ac->nodes[0].transitions[c] = 0;
+            root[k] = 0;
         }
     }
 
     while (front < rear) {
         int state = queue[front++];
 
-        for (int c = 0; c < 256; c++) {
-            int next = ac->nodes[state].transitions[c];
+        for (int k = 0; k < ac->class_count; k++) {
+            int next = ac_row(ac, state)[k];
             if (next == -1) continue;
 
             queue[rear++] = next;
 
             int fail = ac->nodes[state].fail_state;
-            while (ac->nodes[fail].transitions[c] == -1)
+            while (ac_row(ac, fail)[k] == -1)
                 fail = ac->nodes[fail].fail_state;
 
-            ac->nodes[next].fail_state = ac->nodes[fail].transitions[c];
-
-            ACNode *node = &ac->nodes[next];
-            ACNode *fail_node = &ac->nodes[node->fail_state];
-            if (fail_node->output_count > 0) {
-                node->output = track_realloc(node->output,
-                    (size_t)(node->output_count + fail_node->output_count) * sizeof(char *));
-                for (int i = 0; i < fail_node->output_count; i++)
-                    node->output[node->output_count++] = fail_node->output[i];
-            }
+            fail = ac_row(ac, fail)[k];
+            ac_link_fail(ac, next, fail);
+            ac->nodes[next].dict_link = ac_dict_from(ac, fail);
         }
     }
 
     track_free(queue);
+    ac->built = 1;
+    ac_compile(ac);
 }
 
 /* ---------------------------------------------------------------
- *    Perform Aho–Corasick search and print analytics summary
+ *   Release what only updates need once a compiled layout scans
+ *   without it: the trie rows and the reverse failure links. The
+ *   automaton is read-only afterwards; the NFA layout scans the
+ *   trie itself and is left as it is.
  * --------------------------------------------------------------- */
-void ac_search(AhoCorasick *ac, const char *text, size_t len) {
-    if (!ac || !text) return;
+void ac_freeze(AhoCorasick *ac) {
+    if (!ac || !ac->built || ac->frozen || ac->layout == AC_LAYOUT_NFA) return;
 
-    AlgorithmStats s = {0};
-    s.algorithm_name = "Aho–Corasick";
-    s.file_size = (uint64_t)len;
+    for (int i = 0; i < ac->node_count; i++) {
+        track_free(ac->nodes[i].fail_children);
+        ac->nodes[i].fail_children = NULL;
+        ac->nodes[i].fail_child_count = 0;
+        ac->nodes[i].fail_child_cap = 0;
+    }
+    track_free(ac->trie);
+    ac->trie = NULL;
+    ac->frozen = 1;
+}
 
-    struct timespec start, end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
+/* ---------------------------------------------------------------
+ *   Add a pattern to a built automaton, creating only its missing
+ *   trie branch and patching the failure and dictionary links it
+ *   affects. Returns the new pattern id, or -1 for an empty pattern
+ *   or a frozen automaton. Before ac_build this is the same as
+ *   ac_add_pattern.
+ * --------------------------------------------------------------- */
+int ac_insert_pattern(AhoCorasick *ac, const char *pattern, size_t len, int nocase) {
+    if (!ac || !pattern || len == 0) return -1;
+    if (!ac->built) {
+        ac_add_pattern(ac, pattern, len, nocase);
+        return ac->pattern_count - 1;
+    }
+    if (ac->frozen) return -1;
+
+    int pid = ac_register_pattern(ac, pattern, len, nocase);
+    for (size_t i = 0; i < len; i++)
+        ac_assign_class(ac, ac->fold[(unsigned char)pattern[i]]);
+    int state = ac_insert_path(ac, pid);
+
+    int had_output = ac->nodes[state].output_count > 0;
+    ac_add_output(ac, state, pid);
+    if (!had_output)
+        ac_relink_dict(ac, state, state);
+    ac_compile(ac);
+    return pid;
+}
+
+/* ---------------------------------------------------------------
+ *   Free trie nodes left with neither children nor output, from
+ *   state up towards the root. States failing to a freed node
+ *   fall back to its own failure state, the next longest suffix.
+ * --------------------------------------------------------------- */
+static void ac_prune_branch(AhoCorasick *ac, int state, const unsigned char *path) {
+    while (state != 0 && ac->nodes[state].child_count == 0 &&
+           ac->nodes[state].output_count == 0) {
+        ACNode *node = &ac->nodes[state];
+        int fail = node->fail_state;
+        int parent = node->parent;
+
+        for (int i = 0; i < node->fail_child_count; i++)
+            ac_link_fail(ac, node->fail_children[i], fail);
+        ac_unlink_fail(ac, state);
+
+        node = &ac->nodes[state];
+        track_free(node->fail_children);
+        node->fail_children = NULL;
+        node->fail_child_count = 0;
+        node->fail_child_cap = 0;
+
+        ac_row(ac, parent)[path[node->depth - 1]] = (parent == 0) ? 0 : -1;
+        ac->nodes[parent].child_count--;
+
+        node->parent = ac->free_list;
+        ac->free_list = state;
+        state = parent;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Remove a pattern by id. On a built automaton the dictionary
+ *   links that pointed at its state are patched and the trie
+ *   branch only it used is freed. A frozen automaton is left as is.
+ * --------------------------------------------------------------- */
+void ac_remove_pattern(AhoCorasick *ac, int pattern_id) {
+    if (!ac || ac->frozen || pattern_id < 0 || pattern_id >= ac->pattern_count) return;
+    ACPattern *p = &ac->patterns[pattern_id];
+    if (p->length == 0) return;
+
+    unsigned char *path = track_malloc((size_t)p->length);
+    if (!path) {
+        fprintf(stderr, "Memory allocation failed for pattern path\n");
+        exit(EXIT_FAILURE);
+    }
 
     int state = 0;
+    for (int i = 0; i < p->length && state != -1; i++) {
+        path[i] = ac->byte_class[p->bytes[i]];
+        state = ac_child(ac, state, path[i]);
+    }
+
+    if (state > 0) {
+        ACNode *node = &ac->nodes[state];
+        for (int *link = &node->output_head; *link != -1;
+             link = &ac->patterns[*link].next_output) {
+            if (*link != pattern_id) continue;
+            *link = p->next_output;
+            node->output_count--;
+            break;
+        }
+        if (ac->built && node->output_count == 0) {
+            ac_relink_dict(ac, state, node->dict_link);
+            ac_prune_branch(ac, state, path);
+        }
+        if (ac->built) ac_compile(ac);
+    }
+
+    track_free(path);
+    p->bytes = NULL;
+    p->length = 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Report pattern pid as a match ending at in[i].
+ *
+ *   A case-sensitive match that began before this buffer is only
+ *   confirmed on the bytes inside it; its earlier bytes are known
+ *   to match case-insensitively. As a prefilter this may report
+ *   such a straddling match spuriously, but never misses one.
+ * --------------------------------------------------------------- */
+static inline void ac_report_pattern(const AhoCorasick *ac, int pid, const unsigned char *in,
+                                     size_t i, uint64_t base, AlgorithmStats *s,
+                                     MatchCallback on_match, void *ctx) {
+    const ACPattern *p = &ac->patterns[pid];
+    if (!p->nocase) {
+        // Trie matched case-folded; confirm exact bytes
+        size_t plen = (size_t)p->length;
+        size_t have = plen <= i + 1 ? plen : i + 1;
+        s->comparisons++;
+        if (memcmp(in + i + 1 - have, p->bytes + plen - have, have) != 0)
+            return;
+    }
+    s->matches++;
+    if (on_match) on_match(pid, base + (uint64_t)(i + 1), ctx);
+}
+
+/* ---------------------------------------------------------------
+ *   Report the outputs of state out and of every output-bearing
+ *   state on its dictionary chain, for a match ending at in[i].
+ *   Compiled layouts read the flattened lists; the NFA layout,
+ *   which is edited in place, walks the output chains.
+ * --------------------------------------------------------------- */
+static inline void ac_report(const AhoCorasick *ac, int out, const unsigned char *in,
+                             size_t i, uint64_t base, AlgorithmStats *s,
+                             MatchCallback on_match, void *ctx) {
+    for (; out != -1; out = ac->nodes[out].dict_link) {
+        if (ac->out_start) {
+            for (int k = ac->out_start[out]; k < ac->out_start[out + 1]; k++)
+                ac_report_pattern(ac, ac->out_ids[k], in, i, base, s, on_match, ctx);
+        } else {
+            for (int pid = ac->nodes[out].output_head; pid != -1;
+                 pid = ac->patterns[pid].next_output)
+                ac_report_pattern(ac, pid, in, i, base, s, on_match, ctx);
+        }
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Core scan loop (NFA layout): run len bytes through the trie
+ *   starting in *state, following failure links on a miss, report
+ *   match ends offset by base, and leave the final state in *state
+ * --------------------------------------------------------------- */
+static void ac_scan(const AhoCorasick *ac, const unsigned char *in, size_t len,
+                    int *state_io, uint64_t base, AlgorithmStats *s,
+                    MatchCallback on_match, void *ctx) {
+    int state = *state_io;
     for (size_t i = 0; i < len; i++) {
-        unsigned char c = (unsigned char)tolower((unsigned char)text[i]);
-        s.chars_scanned++;
-        s.transitions++;
+        int k = ac->byte_class[in[i]];
+        s->chars_scanned++;
+        s->transitions++;
 
-        while (ac->nodes[state].transitions[c] == -1 && state != 0) {
+        while (ac_row(ac, state)[k] == -1 && state != 0) {
             state = ac->nodes[state].fail_state;
-            s.fail_steps++;
+            s->fail_steps++;
         }
-        state = ac->nodes[state].transitions[c];
+        state = ac_row(ac, state)[k];
         if (state == -1) state = 0;
 
-        ACNode *node = &ac->nodes[state];
-        s.matches += (uint64_t)node->output_count;
+        // Own outputs first, then those of output-bearing suffixes
+        int out = ac->nodes[state].output_count > 0 ? state
+                                                    : ac->nodes[state].dict_link;
+        if (out != -1) ac_report(ac, out, in, i, base, s, on_match, ctx);
+    }
+    *state_io = state;
+}
+
+/* ---------------------------------------------------------------
+ *   Core scan loop (DFA layout): as ac_scan, but every transition
+ *   is a class lookup and a single load from the precomputed
+ *   table, one loop per state id width. Only words with the
+ *   terminal bit lead on to the output lists.
+ * --------------------------------------------------------------- */
+static void ac_scan_dfa(const AhoCorasick *ac, const unsigned char *in, size_t len,
+                        int *state_io, uint64_t base, AlgorithmStats *s,
+                        MatchCallback on_match, void *ctx) {
+    const unsigned char *cls = ac->byte_class;
+    const int *match = ac->match_state;
+    size_t w = (size_t)ac->class_count;
+    uint32_t state = (uint32_t)*state_io;
+
+    if (ac->dfa16) {
+        const uint16_t *dfa = ac->dfa16;
+        for (size_t i = 0; i < len; i++) {
+            uint32_t next = dfa[state * w + cls[in[i]]];
+            state = next & ~AC_DFA16_TERMINAL;
+            if (next & AC_DFA16_TERMINAL)
+                ac_report(ac, match[state], in, i, base, s, on_match, ctx);
+        }
+    } else {
+        const uint32_t *dfa = ac->dfa32;
+        for (size_t i = 0; i < len; i++) {
+            uint32_t next = dfa[state * w + cls[in[i]]];
+            state = next & ~AC_TERMINAL;
+            if (next & AC_TERMINAL)
+                ac_report(ac, match[state], in, i, base, s, on_match, ctx);
+        }
+    }
+    s->chars_scanned += (uint64_t)len;
+    s->transitions += (uint64_t)len;
+    *state_io = (int)state;
+}
+
+/* ---------------------------------------------------------------
+ *   Core scan loop (hybrid layout): a dense state is one load from
+ *   its resolved row; a sparse state tests the class bit and, on a
+ *   hit, ranks it among the set bits to find the child, otherwise
+ *   follows its failure link and tries again
+ * --------------------------------------------------------------- */
+static void ac_scan_hybrid(const AhoCorasick *ac, const unsigned char *in, size_t len,
+                           int *state_io, uint64_t base, AlgorithmStats *s,
+                           MatchCallback on_match, void *ctx) {
+    const unsigned char *cls = ac->byte_class;
+    const int *match = ac->match_state;
+    const uint32_t *index = ac->hyb_index;
+    size_t w = (size_t)ac->class_count;
+    uint32_t state = (uint32_t)*state_io;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned k = cls[in[i]];
+        uint32_t next;
+
+        for (;;) {
+            uint32_t info = index[state];
+            if (info & AC_HYBRID_DENSE) {
+                next = ac->hyb_dense[(size_t)(info & ~AC_HYBRID_DENSE) * w + k];
+                break;
+            }
+            const ACSparseNode *sn = &ac->hyb_sparse[info];
+            uint64_t word = sn->bitmap[k >> 6];
+            uint64_t bit = 1ull << (k & 63);
+            if (word & bit) {
+                uint32_t rank = (uint32_t)__builtin_popcountll(word & (bit - 1));
+                for (unsigned j = 0; j < (k >> 6); j++)
+                    rank += (uint32_t)__builtin_popcountll(sn->bitmap[j]);
+                next = ac->hyb_child[sn->first_child + rank];
+                break;
+            }
+            state = sn->fail;
+            s->fail_steps++;
+        }
+
+        state = next & ~AC_TERMINAL;
+        if (next & AC_TERMINAL)
+            ac_report(ac, match[state], in, i, base, s, on_match, ctx);
+    }
+    s->chars_scanned += (uint64_t)len;
+    s->transitions += (uint64_t)len;
+    *state_io = (int)state;
+}
+
+/* ---------------------------------------------------------------
+ *   Core scan loop (double-array layout): the child of slot s on
+ *   class k is slot base[s] + k when that slot's check is s;
+ *   otherwise follow failure slots, staying at the root on a root
+ *   miss. The check word found also carries the terminal bit.
+ * --------------------------------------------------------------- */
+static void ac_scan_double_array(const AhoCorasick *ac, const unsigned char *in, size_t len,
+                                 int *state_io, uint64_t base, AlgorithmStats *s,
+                                 MatchCallback on_match, void *ctx) {
+    const unsigned char *cls = ac->byte_class;
+    const int *da_base = ac->da_base;
+    const uint32_t *check = ac->da_check;
+    const int *fail = ac->da_fail;
+    const int *match = ac->da_match;
+    int slot = *state_io;
+
+    for (size_t i = 0; i < len; i++) {
+        int k = cls[in[i]];
+        uint32_t terminal = 0;
+
+        for (;;) {
+            int t = da_base[slot] + k;
+            uint32_t owner = check[t];
+            if ((owner & ~AC_TERMINAL) == (uint32_t)slot) {
+                slot = t;
+                terminal = owner & AC_TERMINAL;
+                break;
+            }
+            if (slot == 0) break;
+            slot = fail[slot];
+            s->fail_steps++;
+        }
+
+        if (terminal) ac_report(ac, match[slot], in, i, base, s, on_match, ctx);
+    }
+    s->chars_scanned += (uint64_t)len;
+    s->transitions += (uint64_t)len;
+    *state_io = slot;
+}
+
+/* ---------------------------------------------------------------
+ *    Perform Aho–Corasick search, reporting each match through
+ *    on_match and adding this call's counters and time to s
+ * --------------------------------------------------------------- */
+void ac_search(AhoCorasick *ac, const char *text, size_t len,
+               AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    if (!ac || !text) return;
+
+    ac_search_from(ac, 0, text, len, 0, s, on_match, ctx);
+}
+
+/* ---------------------------------------------------------------
+ *   Resumable search: start in `state` (0 for a fresh stream),
+ *   report match ends offset by base and return the state reached.
+ *   Feeding a stream's buffers in order, each with the state the
+ *   previous one returned, finds matches spanning them with no
+ *   stream bytes kept or rescanned.
+ * --------------------------------------------------------------- */
+int ac_search_from(const AhoCorasick *ac, int state, const char *text, size_t len,
+                   uint64_t base, AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    if (!ac || !text) return state;
+
+    switch (ac->layout) {
+        case AC_LAYOUT_DFA:    s->algorithm_name = "Aho–Corasick (DFA)"; break;
+        case AC_LAYOUT_HYBRID: s->algorithm_name = "Aho–Corasick (Hybrid)"; break;
+        case AC_LAYOUT_DOUBLE_ARRAY:
+                               s->algorithm_name = "Aho–Corasick (Double-Array)"; break;
+        case AC_LAYOUT_NFA:
+        default:               s->algorithm_name = "Aho–Corasick"; break;
     }
+    s->file_size += (uint64_t)len;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (ac->da_base)
+        ac_scan_double_array(ac, (const unsigned char *)text, len, &state, base, s,
+                             on_match, ctx);
+    else if (ac->hyb_index)
+        ac_scan_hybrid(ac, (const unsigned char *)text, len, &state, base, s, on_match, ctx);
+    else if (ac->dfa16 || ac->dfa32)
+        ac_scan_dfa(ac, (const unsigned char *)text, len, &state, base, s, on_match, ctx);
+    else
+        ac_scan(ac, (const unsigned char *)text, len, &state, base, s, on_match, ctx);
 
     clock_gettime(CLOCK_MONOTONIC, &end);
-    s.elapsed_sec = (double)(end.tv_sec - start.tv_sec) +
-                     (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    s->elapsed_sec += (double)(end.tv_sec - start.tv_sec) +
+                      (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    return state;
+}
 
-    compute_throughput(&s);
-    print_algorithm_stats(&s);
+/* ---------------------------------------------------------------
+ *   Streaming search over ac_search_from that also tracks the
+ *   stream offset, so match ends are bytes fed since
+ *   ac_stream_init.
+ * --------------------------------------------------------------- */
+void ac_stream_init(ACStream *st) {
+    st->state = 0;
+    st->offset = 0;
 }
 
+void ac_stream_feed(const AhoCorasick *ac, ACStream *st, const char *text, size_t len,
+                    AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    if (!ac || !text) return;
+
+    st->state = ac_search_from(ac, st->state, text, len, st->offset, s, on_match, ctx);
+    st->offset += (uint64_t)len;
+}
+
+void ac_stream_finish(ACStream *st) {
+    ac_stream_init(st);
+}
+
+/* ---------------------------------------------------------------
+ *   Bytes currently held by the automaton: trie, output and
+ *   reverse-link lists, pattern table and compiled scan tables
+ * --------------------------------------------------------------- */
+size_t ac_memory_bytes(const AhoCorasick *ac) {
+    if (!ac) return 0;
+    size_t bytes = sizeof(AhoCorasick);
+    bytes += (size_t)ac->capacity * sizeof(ACNode);
+    if (ac->trie) bytes += (size_t)ac->capacity * (size_t)ac->class_count * sizeof(int);
+    bytes += (size_t)ac->pattern_capacity * sizeof(ACPattern);
+    for (int i = 0; i < ac->node_count; i++)
+        bytes += (size_t)ac->nodes[i].fail_child_cap * sizeof(int);
+    if (ac->out_start) {
+        bytes += (size_t)(ac->node_count + 1) * sizeof(int);
+        bytes += (size_t)ac->out_start[ac->node_count] * sizeof(int);
+    }
+    size_t cells = (size_t)ac->node_count * (size_t)ac->class_count;
+    if (ac->dfa16) bytes += cells * sizeof(uint16_t);
+    if (ac->dfa32) bytes += cells * sizeof(uint32_t);
+    if (ac->match_state) bytes += (size_t)ac->node_count * sizeof(int);
+    if (ac->hyb_index) bytes += (size_t)ac->node_count * sizeof(uint32_t);
+    bytes += (size_t)ac->hyb_dense_count * (size_t)ac->class_count * sizeof(uint32_t);
+    bytes += (size_t)ac->hyb_sparse_count * sizeof(ACSparseNode);
+    bytes += (size_t)ac->hyb_child_count * sizeof(uint32_t);
+    bytes += (size_t)ac->da_size * 4 * sizeof(int);
+    return bytes;
+}
 
 /* ---------------------------------------------------------------
  * Free all dynamically allocated memory associated with automaton
  * --------------------------------------------------------------- */
 void ac_destroy(AhoCorasick *ac) {
     if (!ac) return;
-    for (int i = 0; i < ac->node_count; i++) {
-        track_free(ac->nodes[i].output);
-    }
+    for (int i = 0; i < ac->node_count; i++)
+        track_free(ac->nodes[i].fail_children);
+    ac_free_compiled(ac);
+    track_free(ac->trie);
     track_free(ac->nodes);
+    track_free(ac->patterns);
     track_free(ac);
 }
@@ -3,37 +3,200 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "../match.h"
+#include "../../parse/analytics.h"
 
 /* ---------------------------------------------------------------
- *  Represents a node in the Aho–Corasick automaton.
+ *  Represents a node in the Aho–Corasick automaton. Its trie
+ *  transitions are row `state` of AhoCorasick.trie.
  *   Each node stores:
- *     - Transition table (for all possible input symbols)
  *     - Failure link (used for backtracking)
- *     - Output list of matched patterns
+ *     - Dictionary link: the nearest state on the failure chain
+ *       that has an output of its own (-1 if none)
+ *     - Output list of the patterns ending exactly here, chained
+ *       through ACPattern.next_output in id order (scans read the
+ *       flattened copy in AhoCorasick.out_start / out_ids)
+ *     - Trie parent and depth, and the reverse failure links
+ *       (fail_children), so that incremental updates can find
+ *       the states whose links they affect
  * --------------------------------------------------------------- */
 typedef struct ACNode {
-    int   transitions[256];
     int   fail_state;
-    char **output;
+    int   dict_link;
+    int   output_head;
     int   output_count;
+    int   parent;
+    int   depth;
+    int   child_count;
+    int  *fail_children;
+    int   fail_child_count;
+    int   fail_child_cap;
 } ACNode;
 
+/* ---------------------------------------------------------------
+ *  A pattern registered with the automaton. Bytes are borrowed
+ *  from the caller and must outlive the automaton. next_output is
+ *  the next pattern ending in the same state, or -1.
+ * --------------------------------------------------------------- */
+typedef struct {
+    const unsigned char *bytes;
+    int                  length;
+    int                  nocase;
+    int                  next_output;
+} ACPattern;
+
+/* ---------------------------------------------------------------
+ *  Scan layouts. The trie with its failure links is always kept
+ *  (it is what ac_insert_pattern / ac_remove_pattern edit); every
+ *  layout other than AC_LAYOUT_NFA is compiled from it by ac_build
+ *  and recompiled after each incremental update.
+ *
+ *    AC_LAYOUT_NFA     scan the trie, walking failure links on a miss
+ *    AC_LAYOUT_DFA     full transition table with every miss
+ *                      resolved at build time: one class lookup
+ *                      and one table load per input byte
+ *    AC_LAYOUT_HYBRID  shallow or high-fanout states keep a dense,
+ *                      fully resolved row; all others are sparse
+ *                      nodes (class bitmap plus popcount-indexed
+ *                      children) that follow failure links on a miss
+ *    AC_LAYOUT_DOUBLE_ARRAY
+ *                      double-array trie: the child of slot s on
+ *                      class k is slot base[s] + k if check[] of
+ *                      that slot is s; failure links on a miss.
+ *                      Scan states are slots, not trie states, so
+ *                      a stream state does not survive a recompile
+ * --------------------------------------------------------------- */
+typedef enum {
+    AC_LAYOUT_NFA,
+    AC_LAYOUT_DFA,
+    AC_LAYOUT_HYBRID,
+    AC_LAYOUT_DOUBLE_ARRAY
+} ACLayout;
+
+/* ---------------------------------------------------------------
+ *  Hybrid layout: a state gets a dense row if it is shallower than
+ *  AC_HYBRID_DENSE_DEPTH or has at least AC_HYBRID_DENSE_FANOUT
+ *  children. hyb_index entries with AC_HYBRID_DENSE set index a
+ *  dense row, the others a sparse node.
+ * --------------------------------------------------------------- */
+#define AC_HYBRID_DENSE_DEPTH   2
+#define AC_HYBRID_DENSE_FANOUT  8
+#define AC_HYBRID_DENSE         0x80000000u
+
+/* ---------------------------------------------------------------
+ *  Terminal bit of a compiled transition word: set when the state
+ *  it leads to has outputs on its dictionary chain, so scans only
+ *  look further on matching states. DFA entries use the top bit
+ *  of their width, which is why 16-bit entries stop at 32,768
+ *  states. Free double-array slots hold AC_DA_FREE in check.
+ * --------------------------------------------------------------- */
+#define AC_TERMINAL             0x80000000u
+#define AC_DFA16_TERMINAL       0x8000u
+#define AC_DA_FREE              0x7FFFFFFFu
+
+/* ---------------------------------------------------------------
+ *  A sparse state of the hybrid layout: which byte classes it has
+ *  a child on, its children in class order from first_child in
+ *  hyb_child (the child on class k sits at the number of set bits
+ *  below k), and its failure state. 40 bytes, against a dense row
+ *  of class_count state ids.
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint64_t bitmap[4];
+    uint32_t first_child;
+    uint32_t fail;
+} ACSparseNode;
+
 /* ---------------------------------------------------------------
 *      Container for the entire Aho–Corasick automaton ADT
+ *   The trie is built over case-folded bytes (fold maps every
+ *   input byte to its lowercase form), so a single automaton
+ *   serves both nocase and case-sensitive patterns; the latter
+ *   are confirmed against the original text on output.
+ *
+ *   Transitions are indexed by byte equivalence class rather than
+ *   by byte: every folded byte occurring in a pattern has a class
+ *   of its own and all other bytes share class 0, on which no
+ *   state has a child. byte_class maps a raw input byte straight
+ *   to its class (folding included), so trie and DFA rows are
+ *   class_count entries wide instead of 256. The trie itself is
+ *   only built by ac_build, once the classes of all patterns
+ *   added so far are known.
+ *
+ *   After ac_build, patterns can be added and removed in place
+ *   with ac_insert_pattern / ac_remove_pattern; a byte new to the
+ *   automaton adds a class and widens every row by one. Pattern
+ *   ids are never reused; nodes freed by removals are kept on
+ *   free_list. ac_freeze gives up updates for memory: with a
+ *   compiled layout, the trie rows and reverse failure links are
+ *   then released.
  * --------------------------------------------------------------- */
 typedef struct {
-    ACNode *nodes;
-    int     node_count;
-    int     capacity;
+    ACNode        *nodes;
+    int            node_count;
+    int            capacity;
+    ACPattern     *patterns;
+    int            pattern_count;
+    int            pattern_capacity;
+    int            free_list;
+    int            built;
+    unsigned char  fold[256];
+    unsigned char  byte_class[256];
+    int            class_count;
+    int           *trie;         // capacity x class_count children, -1: none
+
+    ACLayout       layout;
+    int            frozen;       // trie released by ac_freeze
+    int           *out_start;    // node_count + 1 offsets into out_ids
+    int           *out_ids;      // pattern ids, grouped by state
+    int           *match_state;  // per state: first output-bearing
+                                 // state on its dictionary chain, or -1
+    uint16_t      *dfa16;        // node_count x class_count next states,
+    uint32_t      *dfa32;        // 16-bit while the ids fit, else 32-bit
+
+    uint32_t      *hyb_index;    // per state: dense row or sparse node
+    uint32_t      *hyb_dense;    // resolved rows, class_count wide
+    ACSparseNode  *hyb_sparse;
+    uint32_t      *hyb_child;
+    int            hyb_dense_count;
+    int            hyb_sparse_count;
+    int            hyb_child_count;
+
+    int           *da_base;      // per slot: offset of its children
+    uint32_t      *da_check;     // per slot: owning parent slot, or AC_DA_FREE
+    int           *da_fail;      // per slot: failure slot
+    int           *da_match;     // per slot: as match_state
+    int            da_size;      // slots, padded so base + k stays inside
 } AhoCorasick;
 
+/* ---------------------------------------------------------------
+ *  Position of a streaming search: the automaton state reached
+ *  and the number of stream bytes fed so far.
+ * --------------------------------------------------------------- */
+typedef struct {
+    int      state;
+    uint64_t offset;
+} ACStream;
+
 /* ---------------------------------------------------------------
  *                      AC Prototypes
  * --------------------------------------------------------------- */
 AhoCorasick *ac_create(void);
-void ac_add_pattern(AhoCorasick *ac, const char *pattern);
+void ac_set_layout(AhoCorasick *ac, ACLayout layout);
+void ac_add_pattern(AhoCorasick *ac, const char *pattern, size_t len, int nocase);
 void ac_build(AhoCorasick *ac);
-void ac_search(AhoCorasick *ac, const char *text, size_t len);
+void ac_freeze(AhoCorasick *ac);
+int  ac_insert_pattern(AhoCorasick *ac, const char *pattern, size_t len, int nocase);
+void ac_remove_pattern(AhoCorasick *ac, int pattern_id);
+void ac_search(AhoCorasick *ac, const char *text, size_t len,
+               AlgorithmStats *s, MatchCallback on_match, void *ctx);
+int  ac_search_from(const AhoCorasick *ac, int state, const char *text, size_t len,
+                    uint64_t base, AlgorithmStats *s, MatchCallback on_match, void *ctx);
+void ac_stream_init(ACStream *st);
+void ac_stream_feed(const AhoCorasick *ac, ACStream *st, const char *text, size_t len,
+                    AlgorithmStats *s, MatchCallback on_match, void *ctx);
+void ac_stream_finish(ACStream *st);
+size_t ac_memory_bytes(const AhoCorasick *ac);
 void ac_destroy(AhoCorasick *ac);
 
 #endif  // SRC_ALGORITHMS_AC_AC_H_
@@ -7,7 +7,7 @@
  * fairly bad as we need to iterate through all the patterns and match it.
  * Reference:
  * https://medium.com/@siddharth.21/the-boyer-moore-string-search-algorithm-674906cab162,
- * slightly changed to break when first match is found.
+ * changed to report every occurrence of each pattern.
  * https://medium.com/@neethamadhu.ma/good-suffix-rule-in-boyer-moore-algorithm-explained-simply-9d9b6d20a773
  * https://www.geeksforgeeks.org/dsa/boyer-moore-algorithm-for-pattern-searching/
  *
@@ -34,11 +34,17 @@ BMPatterns *bm_preprocessing(PatternSet *ps) {
     bm_patterns->num_patterns = ps->pattern_count;
 
     for (int i = 0; i < ps->pattern_count; i++) {
-        char *pattern = ps->patterns[i];
+        const char *pattern = (const char *)ps_pattern(ps, i);
+        int len = ps->pattern_lens[i];
         PatternTable *curr_pattern = &bm_patterns->patterns[i];
-        curr_pattern->pattern = track_malloc(sizeof(char) * (strlen(pattern) + 1));
+        curr_pattern->pattern = track_malloc(sizeof(char) * (size_t)len);
+        curr_pattern->goodSuffixTable = track_calloc((size_t)len + 1, sizeof(int));
 
-        strcpy(curr_pattern->pattern, pattern);
+        curr_pattern->nocase = ps->nocase[i];
+        for (int c = 0; c < len; c++)
+            curr_pattern->pattern[c] = curr_pattern->nocase
+                ? (char)tolower((unsigned char)pattern[c]) : pattern[c];
+        pattern = curr_pattern->pattern;
 
         // initialse pattern table with length values
         for (int k = 0; k < ALPHABET_SIZE; k++) {
@@ -46,8 +52,8 @@ BMPatterns *bm_preprocessing(PatternSet *ps) {
         }
 
         int j = 0;
-        for (; pattern[j] != '\0'; j++) {
-            if (j > curr_pattern->badCharTable[(int)pattern[j]]) {
+        for (; j < len; j++) {
+            if (j > curr_pattern->badCharTable[(int)(unsigned char)pattern[j]]) {
                 curr_pattern->badCharTable[(int)(unsigned char)pattern[j]] = j;
             }
             curr_pattern->goodSuffixTable[j] = 0;
@@ -87,10 +93,18 @@ BMPatterns *bm_preprocessing(PatternSet *ps) {
     return bm_patterns;
 }
 
-void bm_search(BMPatterns *bm, const char *text, size_t text_len) {
-    AlgorithmStats s = {0};
-    s.algorithm_name = "BM (Only with Bad Character Heuristic)";
-    s.file_size = (uint64_t)bm->num_patterns;
+/* ---------------------------------------------------------------
+ *   Text byte at pos as the pattern's tables see it
+ * --------------------------------------------------------------- */
+static inline unsigned char bm_text_byte(const PatternTable *p, const char *text, int pos) {
+    unsigned char c = (unsigned char)text[pos];
+    return p->nocase ? (unsigned char)tolower(c) : c;
+}
+
+void bm_search(BMPatterns *bm, const char *text, size_t text_len,
+               AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    s->algorithm_name = "BM (Only with Bad Character Heuristic)";
+    s->file_size += (uint64_t)text_len;
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
 
@@ -99,19 +113,22 @@ void bm_search(BMPatterns *bm, const char *text, size_t text_len) {
         shift = 0;
 
         PatternTable curr_table = bm->patterns[i];
-        int j = curr_table.pattern_length - 1;
         while ((size_t)(shift + curr_table.pattern_length) - 1 < text_len) {
             // test starting from the final character in the pattern to
             // to the start of the text
-            while (j >= 0 && curr_table.pattern[j] != '\0' && curr_table.pattern[j] == text[shift + j]) {
+            int j = curr_table.pattern_length - 1;
+            while (j >= 0 && (unsigned char)curr_table.pattern[j] ==
+                                 bm_text_byte(&curr_table, text, shift + j)) {
                 j--;
             }
 
             if (j < 0) {
-                // then we have a match at that shift value
-                s.exact_matches++;
-
-                break;
+                // then we have a match at that shift value; keep going so
+                // every occurrence is reported to the rule evaluator
+                s->exact_matches++;
+                if (on_match)
+                    on_match(i, (uint64_t)(shift + curr_table.pattern_length), ctx);
+                shift++;
             } else {
                 // utilise bad character heuristic since we have already
                 // compared everything to the right of pattern position at mismatch
@@ -119,7 +136,8 @@ void bm_search(BMPatterns *bm, const char *text, size_t text_len) {
                 // occurence of char in pattern if in pattern, else shift 1.
                 // also, can use good suffix heuristic, and skip such that
                 // the next prefix matches
-                int bad_skip_past_mismatch = bm->patterns[i].badCharTable[(int)(unsigned char)text[shift + j]];
+                int bad_skip_past_mismatch =
+                    bm->patterns[i].badCharTable[bm_text_byte(&curr_table, text, shift + j)];
                 int skip_past_mismatch = bad_skip_past_mismatch;
                 if (shift + j + 1 <= bm->patterns[i].pattern_length) {
                     int good_skip_past_mismatch = bm->patterns[i].goodSuffixTable[shift + j + 1];
@@ -139,11 +157,34 @@ void bm_search(BMPatterns *bm, const char *text, size_t text_len) {
     }
 
     clock_gettime(CLOCK_MONOTONIC, &end);
-    s.elapsed_sec = (double)(end.tv_sec - start.tv_sec) +
-                     (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    s->elapsed_sec += (double)(end.tv_sec - start.tv_sec) +
+                      (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static void bm_stream_scan(const void *engine, const unsigned char *text, size_t len,
+                           AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    const BMStream *st = engine;
+    bm_search(st->bm, (const char *)text, len, s, on_match, ctx);
+}
+
+void bm_stream_init(BMStream *st, BMPatterns *bm) {
+    int max_len = 0;
+    for (int i = 0; i < bm->num_patterns; i++)
+        if (bm->patterns[i].pattern_length > max_len)
+            max_len = bm->patterns[i].pattern_length;
+
+    st->bm = bm;
+    stream_carry_init(&st->carry, max_len);
+}
+
+void bm_stream_feed(BMStream *st, const char *text, size_t len,
+                    AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    stream_carry_feed(&st->carry, (const unsigned char *)text, len,
+                      bm_stream_scan, st, s, on_match, ctx);
+}
 
-    compute_throughput(&s);
-    print_algorithm_stats(&s);
+void bm_stream_finish(BMStream *st) {
+    stream_carry_finish(&st->carry);
 }
 
 void bm_free_tables(BMPatterns *bm) {
@@ -153,6 +194,7 @@ void bm_free_tables(BMPatterns *bm) {
 
     for (int i = 0; i < bm->num_patterns; i++) {
         track_free(bm->patterns[i].borderTable);
+        track_free(bm->patterns[i].goodSuffixTable);
         track_free(bm->patterns[i].pattern);
     }
 
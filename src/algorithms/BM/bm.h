@@ -5,18 +5,23 @@
 #include <stdio.h>
 #include "../../parse/analytics.h"
 #include "../WM/wm.h"
+#include "../match.h"
+#include "../stream.h"
 
 #define NOT_IN_PATTERN -1
 /**
  * Mapping of a pattern given from a Snort Rule to its corresponding
  * BadCharacter, Good Suffix shift table and the border table where a border is
  * defined as a prefix text suffix trio where the prefix and suffix are equal.
+ * A nocase pattern is stored, and its tables built, lower-cased; the text is
+ * lower-cased as it is compared against it.
  */
 typedef struct {
     char *pattern;
     int pattern_length;
+    int nocase;
     int badCharTable[ALPHABET_SIZE];
-    int goodSuffixTable[ALPHABET_SIZE];
+    int *goodSuffixTable;
     int *borderTable;
 } PatternTable;
 
@@ -28,12 +33,27 @@ typedef struct {
     int num_patterns;
 } BMPatterns;
 
+/**
+ * Streaming (chunked) search state: the tables plus the chunk
+ * boundary carry
+ */
+typedef struct {
+    BMPatterns *bm;
+    StreamCarry carry;
+} BMStream;
+
 /* ---------------------------------------------------------------
  *                      Function Prototypes
  * --------------------------------------------------------------- */
 BMPatterns *bm_preprocessing(PatternSet *ps);
 
-void bm_search(BMPatterns *bm, const char *text, size_t text_len);
+void bm_search(BMPatterns *bm, const char *text, size_t text_len,
+               AlgorithmStats *s, MatchCallback on_match, void *ctx);
+
+void bm_stream_init(BMStream *st, BMPatterns *bm);
+void bm_stream_feed(BMStream *st, const char *text, size_t len,
+                    AlgorithmStats *s, MatchCallback on_match, void *ctx);
+void bm_stream_finish(BMStream *st);
 
 void bm_free_tables(BMPatterns *bm);
 
@@ -25,7 +25,8 @@ void setHorspoolSearch(const char *text, uint64_t textLength,
                        Pattern *patterns, int numPatterns __attribute__((unused)),
                        int *shiftTable, int minLength,
                        PatternList *hashTable,
-                       AlgorithmStats *s) {
+                       AlgorithmStats *s,
+                       MatchCallback on_match, void *ctx) {
     if (minLength <= 0 || !text || !patterns) return;
 
     uint64_t pos = 0;
@@ -71,6 +72,8 @@ void setHorspoolSearch(const char *text, uint64_t textLength,
             if (matched) {
                 s->matches++;
                 foundMatch = 1;
+                if (on_match)
+                    on_match(patterns[p].id, pos + (uint64_t)patternLen, ctx);
                 // Don't break - continue checking other patterns
                 // (overlapping matches are valid)
             }
@@ -91,7 +94,8 @@ void setHorspoolSearch(const char *text, uint64_t textLength,
  *                          Public API
  * --------------------------------------------------------------- */
 void performSetHorspool(const char *text, uint64_t textLength,
-                        Pattern *patterns, int numPatterns) {
+                        Pattern *patterns, int numPatterns,
+                        MatchCallback on_match, void *ctx) {
     AlgorithmStats s = {0};
     s.algorithm_name = "Set–Horspool";
     s.file_size = textLength;
@@ -130,7 +134,8 @@ void performSetHorspool(const char *text, uint64_t textLength,
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    setHorspoolSearch(text, textLength, patterns, numPatterns, shiftTable, minLength, hashTable, &s);
+    setHorspoolSearch(text, textLength, patterns, numPatterns, shiftTable, minLength, hashTable, &s,
+                      on_match, ctx);
 
     clock_gettime(CLOCK_MONOTONIC, &end);
     s.elapsed_sec = (double)(end.tv_sec - start.tv_sec) +
@@ -144,6 +149,41 @@ void performSetHorspool(const char *text, uint64_t textLength,
     track_free(shiftTable);
 }
 
+/* ---------------------------------------------------------------
+ *              Streaming API (chunked input)
+ * --------------------------------------------------------------- */
+static void setHorspoolStreamScan(const void *engine, const unsigned char *text,
+                                  size_t len, AlgorithmStats *s,
+                                  MatchCallback on_match, void *ctx) {
+    const SetHorspoolStream *st = engine;
+    setHorspoolSearch((const char *)text, (uint64_t)len, st->patterns, st->numPatterns,
+                      st->shiftTable, st->minLength, st->hashTable, s, on_match, ctx);
+}
+
+void setHorspoolStreamInit(SetHorspoolStream *st, Pattern *patterns, int numPatterns,
+                           int *shiftTable, int minLength, PatternList *hashTable) {
+    int maxLength = 0;
+    for (int i = 0; i < numPatterns; i++)
+        if (patterns[i].length > maxLength) maxLength = patterns[i].length;
+
+    st->patterns = patterns;
+    st->numPatterns = numPatterns;
+    st->shiftTable = shiftTable;
+    st->minLength = minLength;
+    st->hashTable = hashTable;
+    stream_carry_init(&st->carry, maxLength);
+}
+
+void setHorspoolStreamFeed(SetHorspoolStream *st, const char *text, size_t len,
+                           AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    stream_carry_feed(&st->carry, (const unsigned char *)text, len,
+                      setHorspoolStreamScan, st, s, on_match, ctx);
+}
+
+void setHorspoolStreamFinish(SetHorspoolStream *st) {
+    stream_carry_finish(&st->carry);
+}
+
 /* ---------------------------------------------------------------
  *                 Utility: Build Shift Table
  * --------------------------------------------------------------- */
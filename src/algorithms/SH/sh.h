@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "../../parse/analytics.h"
+#include "../match.h"
+#include "../stream.h"
 /* ---------------------------------------------------------------
  *                          Constants
  * --------------------------------------------------------------- */
@@ -32,7 +34,7 @@ typedef struct {
  *   - Rule metadata (sid, message, nocase flag)
  * --------------------------------------------------------------- */
 typedef struct {
-    char *pattern;
+    const char *pattern;
     int   length;
     int   id;
     char *msg;
@@ -40,6 +42,20 @@ typedef struct {
     int   nocase;
 } Pattern;
 
+/* ---------------------------------------------------------------
+ * Struct: SetHorspoolStream
+ *  Prebuilt tables plus the chunk boundary carry for a streaming
+ *  (chunked) Set Horspool search
+ * --------------------------------------------------------------- */
+typedef struct {
+    Pattern     *patterns;
+    int          numPatterns;
+    int         *shiftTable;
+    int          minLength;
+    PatternList *hashTable;
+    StreamCarry  carry;
+} SetHorspoolStream;
+
 /* ---------------------------------------------------------------
  *                      Function Prototypes
  * --------------------------------------------------------------- */
@@ -47,9 +63,16 @@ void setHorspoolSearch(const char *text, uint64_t textLength,
                        Pattern *patterns, int numPatterns,
                        int *shiftTable, int minLength,
                        PatternList *hashTable,
-                       AlgorithmStats *s);
+                       AlgorithmStats *s,
+                       MatchCallback on_match, void *ctx);
 void performSetHorspool(const char *text, uint64_t textLength,
-                        Pattern *patterns, int numPatterns);
+                        Pattern *patterns, int numPatterns,
+                        MatchCallback on_match, void *ctx);
+void setHorspoolStreamInit(SetHorspoolStream *st, Pattern *patterns, int numPatterns,
+                           int *shiftTable, int minLength, PatternList *hashTable);
+void setHorspoolStreamFeed(SetHorspoolStream *st, const char *text, size_t len,
+                           AlgorithmStats *s, MatchCallback on_match, void *ctx);
+void setHorspoolStreamFinish(SetHorspoolStream *st);
 void buildSetHorspoolShiftTable(Pattern *patterns, int numPatterns, int *shiftTable);
 void buildPatternHashTable(Pattern *patterns, int numPatterns, int minLength, PatternList *hashTable);
 void freePatternHashTable(PatternList *hashTable);
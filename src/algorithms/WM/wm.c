@@ -28,16 +28,28 @@
 #include "../../parse/analytics.h"
 
 /* ---------------------------------------------------------------
- *   Perform Wu–Manber multi-pattern search and print performance
- *   and memory analytics.
+ *   Compare n bytes, folding ASCII case when nocase is set
+ * --------------------------------------------------------------- */
+static int wm_equal(const unsigned char *a, const unsigned char *b, int n, int nocase) {
+    if (!nocase) return memcmp(a, b, (size_t)n) == 0;
+    for (int i = 0; i < n; i++)
+        if (wm_fold(a[i]) != wm_fold(b[i])) return 0;
+    return 1;
+}
+
+/* ---------------------------------------------------------------
+ *   Perform Wu–Manber multi-pattern search, reporting each full
+ *   pattern match through on_match and adding this call's
+ *   counters and time to s.
  * --------------------------------------------------------------- */
 void wm_search(const unsigned char *text, int n,
-               const PatternSet *ps, const WuManberTables *tbl) {
+               const PatternSet *ps, const WuManberTables *tbl,
+               AlgorithmStats *s, MatchCallback on_match, void *ctx) {
     if (!text || !ps || !tbl) return;
 
-    AlgorithmStats s = {0};
-    s.algorithm_name = "Wu–Manber (Deterministic)";
-    s.file_size = (uint64_t)n;
+    s->algorithm_name = tbl->prefix_filter.bit_array ? "Wu–Manber (Probabilistic)"
+                                                     : "Wu–Manber (Deterministic)";
+    s->file_size += (uint64_t)n;
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
 
@@ -48,46 +60,76 @@ void wm_search(const unsigned char *text, int n,
     int use_bloom = (bf->bit_array != NULL);
 
     for (int i = m - 1; i < n; ) {
-        s.windows++;
+        s->windows++;
 
         uint32_t key = block_key(text + i - B + 1, B, B);
         int shift = tbl->shift_table[key];
-        s.sum_shift += (uint64_t)shift;
+        s->sum_shift += (uint64_t)shift;
 
         if (shift > 0) {
             i += shift;
             continue;
         }
 
-        s.hash_hits++;
+        s->hash_hits++;
 
         if (use_bloom) {
-            s.bloom_checks++;
-            if (!bloom_check(bf, text + i - m + 1, B)) {
+            s->bloom_checks++;
+            unsigned char folded[4];
+            fold_prefix(text + i - m + 1, B, folded);
+            if (!bloom_check(bf, folded, B)) {
                 i++;
                 continue;
             }
-            s.bloom_pass++;
+            s->bloom_pass++;
         }
 
-        uint32_t h = hash_prefix(text + i - m + 1, m, B);
+        // Candidate patterns start at the window start; verify each
+        // one over its full length, not just the m-byte window
+        int win = i - m + 1;
+        uint32_t h = hash_prefix(text + win, m, B);
         for (int pid = tbl->hash_table[key]; pid != -1; pid = tbl->next[pid]) {
-            s.chain_steps++;
-            if (tbl->prefix_hash[pid] == h &&
-                strncmp((const char *)text + i - m + 1,
-                        ps->patterns[pid],
-                        (size_t)ps->min_length) == 0) {
-                s.exact_matches++;
-                s.verif_after_bloom++;
+            s->chain_steps++;
+            int L = tbl->pat_len[pid];
+            if (tbl->prefix_hash[pid] == h && win + L <= n &&
+                wm_equal(text + win, ps_pattern(ps, pid), L, ps->nocase[pid])) {
+                s->exact_matches++;
+                s->verif_after_bloom++;
+                if (on_match) on_match(pid, (uint64_t)(win + L), ctx);
             }
         }
         i++;
     }
 
     clock_gettime(CLOCK_MONOTONIC, &end);
-    s.elapsed_sec = (double)(end.tv_sec - start.tv_sec) +
-                     (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    s->elapsed_sec += (double)(end.tv_sec - start.tv_sec) +
+                      (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* ---------------------------------------------------------------
+ *                Streaming (chunked) Wu–Manber
+ * --------------------------------------------------------------- */
+static void wm_stream_scan(const void *engine, const unsigned char *text, size_t len,
+                           AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    const WMStream *st = engine;
+    wm_search(text, (int)len, st->ps, st->tbl, s, on_match, ctx);
+}
+
+void wm_stream_init(WMStream *st, const PatternSet *ps, const WuManberTables *tbl) {
+    int max_len = 0;
+    for (int i = 0; i < ps->pattern_count; i++)
+        if (ps->pattern_lens[i] > max_len) max_len = ps->pattern_lens[i];
+
+    st->ps = ps;
+    st->tbl = tbl;
+    stream_carry_init(&st->carry, max_len);
+}
+
+void wm_stream_feed(WMStream *st, const unsigned char *text, size_t len,
+                    AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    stream_carry_feed(&st->carry, text, len, wm_stream_scan, st, s, on_match, ctx);
+}
 
-    compute_throughput(&s);
-    print_algorithm_stats(&s);
+void wm_stream_finish(WMStream *st) {
+    stream_carry_finish(&st->carry);
 }
@@ -3,13 +3,14 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "../match.h"
+#include "../stream.h"
+#include "../../parse/analytics.h"
 
 /* ---------------------------------------------------------------
  *                          Constants
  * --------------------------------------------------------------- */
 #define ALPHABET_SIZE    256
-#define MAX_PATTERNS     10000
-#define MAX_PATTERN_LEN  256
 
 /* ---------------------------------------------------------------
  * BloomFilter:
@@ -24,16 +25,50 @@ typedef struct {
 
 /* ---------------------------------------------------------------
  * PatternSet:
- *   Holds all user-provided patterns and computed statistics
+ *   Holds all user-provided patterns and computed statistics.
+ *   Pattern bytes are packed back to back in a single growable
+ *   pool and indexed by offset/length, so memory scales with the
+ *   actual content bytes. Patterns are decoded raw bytes and may
+ *   contain NULs, so pattern_lens is authoritative (no strlen).
+ *   nocase[i] is set when the rule marks pattern i case-insensitive.
+ *   Identical literals are interned, so one pattern may be shared
+ *   by several rules: rule_ids[rule_start[i] .. rule_start[i + 1])
+ *   lists the rules whose fast pattern is pattern i. The pool may
+ *   also hold bytes of contents that are not indexed as patterns
+ *   (non-fast-pattern contents of a rule).
  * --------------------------------------------------------------- */
 typedef struct {
-    char      patterns[MAX_PATTERNS][MAX_PATTERN_LEN];
-    char    **rule_refs;
-    int       pattern_count;
-    int       min_length;
-    int       avg_length;
+    unsigned char *pool;
+    size_t         pool_len;
+    size_t         pool_cap;
+    uint32_t      *offsets;
+    int           *pattern_lens;
+    uint8_t       *nocase;
+    uint32_t      *rule_start;
+    int           *rule_ids;
+    int            pattern_count;
+    int            pattern_cap;
+    int            min_length;
+    int            avg_length;
 } PatternSet;
 
+/* ---------------------------------------------------------------
+ *      Return a pointer to the raw bytes of pattern i
+ * --------------------------------------------------------------- */
+static inline const unsigned char *ps_pattern(const PatternSet *ps, int i) {
+    return ps->pool + ps->offsets[i];
+}
+
+/* ---------------------------------------------------------------
+ *   ASCII case fold. Block keys, prefix hashes and the Bloom
+ *   filter are all taken over folded bytes, so nocase patterns
+ *   reach verification whatever the case of the text; patterns
+ *   without nocase are then compared exactly.
+ * --------------------------------------------------------------- */
+static inline unsigned char wm_fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
 /* ---------------------------------------------------------------
  * WuManberTables:
  *   Stores preprocessed shift and hash tables for Wu–Manber,
@@ -49,11 +84,22 @@ typedef struct {
     BloomFilter prefix_filter;
 } WuManberTables;
 
+/* ---------------------------------------------------------------
+ *  Streaming Wu–Manber search over a chunked input (see
+ *  StreamCarry for how chunk boundaries are handled)
+ * --------------------------------------------------------------- */
+typedef struct {
+    const PatternSet     *ps;
+    const WuManberTables *tbl;
+    StreamCarry           carry;
+} WMStream;
+
 /* ---------------------------------------------------------------
  *           Wu–Manber Preprocessing and Search API
  * --------------------------------------------------------------- */
 uint32_t block_key(const unsigned char *s, int avail, int B);
 uint32_t hash_prefix(const unsigned char *s, int len, int B);
+void     fold_prefix(const unsigned char *s, int len, unsigned char *out);
 
 int choose_block_size(const PatternSet *ps);
 void wm_prepare_patterns(PatternSet *ps, int B);
@@ -61,7 +107,12 @@ void wm_build_tables(const PatternSet *ps, WuManberTables *tbl, int use_bloom);
 void wm_free_tables(WuManberTables *tbl);
 
 void wm_search(const unsigned char *text, int n,
-               const PatternSet *ps, const WuManberTables *tbl);
+               const PatternSet *ps, const WuManberTables *tbl,
+               AlgorithmStats *s, MatchCallback on_match, void *ctx);
+void wm_stream_init(WMStream *st, const PatternSet *ps, const WuManberTables *tbl);
+void wm_stream_feed(WMStream *st, const unsigned char *text, size_t len,
+                    AlgorithmStats *s, MatchCallback on_match, void *ctx);
+void wm_stream_finish(WMStream *st);
 
 /* ---------------------------------------------------------------
  *                      Bloom Filter API
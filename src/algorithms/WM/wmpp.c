@@ -36,29 +36,38 @@ int choose_block_size(const PatternSet *ps) {
 }
 
 /* ---------------------------------------------------------------
- *   Compute a lightweight FNV-1a hash of the first B bytes of a
- *   pattern for quick mismatch filtering during search
+ *   Compute a lightweight FNV-1a hash of the first B (case-folded)
+ *   bytes of a pattern for quick mismatch filtering during search
  * --------------------------------------------------------------- */
 uint32_t hash_prefix(const unsigned char *s, int len, int B) {
     uint32_t h = 0x811C9DC5;
     for (int i = 0; i < (len < B ? len : B); ++i)
-        h = (h ^ s[i]) * 0x01000193;
+        h = (h ^ wm_fold(s[i])) * 0x01000193;
     return h;
 }
 
 /* ---------------------------------------------------------------
- *   Convert a sequence of B bytes into a unique numeric key used
- *   for indexing shift and hash tables
+ *   Convert a sequence of B (case-folded) bytes into a unique
+ *   numeric key used for indexing shift and hash tables
  * --------------------------------------------------------------- */
 uint32_t block_key(const unsigned char *s, int avail, int B) {
     uint32_t k = 0;
     for (int i = 0; i < B; ++i) {
-        unsigned v = (i < avail) ? s[i] : 0;
+        unsigned v = (i < avail) ? wm_fold(s[i]) : 0;
         k |= ((uint32_t)v) << (8 * i);
     }
     return k;
 }
 
+/* ---------------------------------------------------------------
+ *   Copy the first len (at most B) bytes of s case-folded into
+ *   out, the form the Bloom filter is keyed on
+ * --------------------------------------------------------------- */
+void fold_prefix(const unsigned char *s, int len, unsigned char *out) {
+    for (int i = 0; i < len; ++i)
+        out[i] = wm_fold(s[i]);
+}
+
 /* ---------------------------------------------------------------
  *   Identify the shortest pattern length (m) for the window size
  * --------------------------------------------------------------- */
@@ -67,7 +76,7 @@ void wm_prepare_patterns(PatternSet *ps, int B) {
 
     int m = INT_MAX;
     for (int i = 0; i < ps->pattern_count; ++i) {
-        int L = (int)strnlen(ps->patterns[i], MAX_PATTERN_LEN);
+        int L = ps->pattern_lens[i];
         if (L > 0 && L < m) m = L;
     }
 
@@ -99,24 +108,24 @@ void wm_build_tables(const PatternSet *ps, WuManberTables *tbl, int use_bloom) {
         tbl->hash_table[i]  = -1;
     }
 
-    if (use_bloom) {
-        printf("[*] Using Bloom filter prefix (probabilistic mode).\n");
+    if (use_bloom)
         bloom_init(&tbl->prefix_filter, ps->pattern_count, 0.01);
-    } else {
-        printf("[*] Using Hash prefix mode (deterministic mode).\n");
+    else
         tbl->prefix_filter.bit_array = NULL;
-    }
 
     for (int pid = 0; pid < ps->pattern_count; ++pid) {
-        const unsigned char *P = (const unsigned char *)ps->patterns[pid];
-        int L = (int)strlen((const char *)P);
+        const unsigned char *P = ps_pattern(ps, pid);
+        int L = ps->pattern_lens[pid];
 
         tbl->pat_len[pid] = L;
         tbl->prefix_hash[pid] = hash_prefix(P, L, B);
         tbl->next[pid] = -1;
 
-        if (use_bloom)
-            bloom_add(&tbl->prefix_filter, P, (L < B ? L : B));
+        if (use_bloom) {
+            unsigned char folded[4];
+            fold_prefix(P, (L < B ? L : B), folded);
+            bloom_add(&tbl->prefix_filter, folded, (L < B ? L : B));
+        }
 
         for (int j = 0; j <= m - B; ++j) {
             uint32_t x = block_key(P + j, L - j, B);
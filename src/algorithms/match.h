@@ -0,0 +1,15 @@
+#ifndef SRC_ALGORITHMS_MATCH_H_
+#define SRC_ALGORITHMS_MATCH_H_
+
+#include <stdint.h>
+
+/* ---------------------------------------------------------------
+ * MatchCallback:
+ *   Invoked by every search engine for each verified occurrence
+ *   of a pattern. pattern_id is the PatternSet index and end is
+ *   the offset one past the last matched byte in the scanned text.
+ *   A NULL callback means the engine only gathers statistics.
+ * --------------------------------------------------------------- */
+typedef void (*MatchCallback)(int pattern_id, uint64_t end, void *ctx);
+
+#endif  // SRC_ALGORITHMS_MATCH_H_
@@ -0,0 +1,278 @@
+/*
+ *                  Generic Multi-Pattern Matcher
+ *
+ * ---------------------------------------------------------------
+ * Builds and drives whichever engine was selected (Wu–Manber,
+ * Aho–Corasick, Set–Horspool or Boyer-Moore) over a PatternSet.
+ * Pattern ids reported through the callback are indices into
+ * that PatternSet for every engine.
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "matcher.h"
+#include "../parse/analytics.h"
+
+/* ---------------------------------------------------------------
+ *               Human-readable name of an algorithm
+ * --------------------------------------------------------------- */
+const char *matcher_name(AlgorithmType alg) {
+    switch (alg) {
+        case ALG_AC:        return "Aho–Corasick";
+        case ALG_AC_DFA:    return "Aho–Corasick (DFA)";
+        case ALG_AC_HYBRID: return "Aho–Corasick (Hybrid)";
+        case ALG_AC_DA:     return "Aho–Corasick (Double-Array)";
+        case ALG_WM_PROB:   return "Wu–Manber (Probabilistic)";
+        case ALG_SH:        return "Set–Horspool";
+        case ALG_BM:        return "Boyer-Moore";
+        case ALG_WM_DET:
+        default:            return "Wu–Manber (Deterministic)";
+    }
+}
+
+/* ---------------------------------------------------------------
+ *      Compile the patterns of ps into an engine of type alg
+ * --------------------------------------------------------------- */
+Matcher *matcher_create(AlgorithmType alg, PatternSet *ps) {
+    Matcher *m = track_calloc(1, sizeof(Matcher));
+    if (!m) {
+        fprintf(stderr, "Memory allocation failed for Matcher\n");
+        exit(EXIT_FAILURE);
+    }
+    m->alg = alg;
+    m->ps = ps;
+
+    switch (alg) {
+        case ALG_AC:
+        case ALG_AC_DFA:
+        case ALG_AC_HYBRID:
+        case ALG_AC_DA:
+            m->ac = ac_create();
+            ac_set_layout(m->ac, alg == ALG_AC_DFA    ? AC_LAYOUT_DFA :
+                                 alg == ALG_AC_HYBRID ? AC_LAYOUT_HYBRID :
+                                 alg == ALG_AC_DA     ? AC_LAYOUT_DOUBLE_ARRAY : AC_LAYOUT_NFA);
+            for (int i = 0; i < ps->pattern_count; i++)
+                ac_add_pattern(m->ac, (const char *)ps_pattern(ps, i),
+                               (size_t)ps->pattern_lens[i], ps->nocase[i]);
+            ac_build(m->ac);
+            ac_freeze(m->ac);  // matchers are never updated in place
+            break;
+
+        case ALG_WM_DET:
+        case ALG_WM_PROB:
+            m->wm = track_malloc(sizeof(WuManberTables));
+            if (!m->wm) {
+                fprintf(stderr, "Memory allocation failed for WuManberTables\n");
+                exit(EXIT_FAILURE);
+            }
+            wm_build_tables(ps, m->wm, alg == ALG_WM_PROB);
+            break;
+
+        case ALG_SH:
+            m->sh_patterns = track_calloc((size_t)ps->pattern_count + 1, sizeof(Pattern));
+            if (!m->sh_patterns) {
+                fprintf(stderr, "Memory allocation failed for Set-Horspool patterns\n");
+                exit(EXIT_FAILURE);
+            }
+            for (int i = 0; i < ps->pattern_count; i++) {
+                m->sh_patterns[i].pattern = (const char *)ps_pattern(ps, i);
+                m->sh_patterns[i].length = ps->pattern_lens[i];
+                m->sh_patterns[i].id = i;
+                m->sh_patterns[i].nocase = ps->nocase[i];
+            }
+
+            // Tables are built once here rather than on every scan
+            if (ps->pattern_count == 0) break;
+            m->sh_min_length = ps->pattern_lens[0];
+            for (int i = 1; i < ps->pattern_count; i++)
+                if (ps->pattern_lens[i] < m->sh_min_length)
+                    m->sh_min_length = ps->pattern_lens[i];
+
+            m->sh_shift = track_malloc(MAX_CHAR * sizeof(int));
+            m->sh_hash = track_calloc(MAX_CHAR, sizeof(PatternList));
+            if (!m->sh_shift || !m->sh_hash) {
+                fprintf(stderr, "Memory allocation failed for Set-Horspool tables\n");
+                exit(EXIT_FAILURE);
+            }
+            buildSetHorspoolShiftTable(m->sh_patterns, ps->pattern_count, m->sh_shift);
+            buildPatternHashTable(m->sh_patterns, ps->pattern_count, m->sh_min_length,
+                                  m->sh_hash);
+            break;
+
+        case ALG_BM:
+            m->bm = bm_preprocessing(ps);
+            break;
+    }
+    return m;
+}
+
+/* ---------------------------------------------------------------
+ *     Scan len bytes of data, reporting hits through on_match
+ *     and accumulating the engine's counters and time into s
+ * --------------------------------------------------------------- */
+void matcher_scan(const Matcher *m, const unsigned char *data, size_t len,
+                  AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    switch (m->alg) {
+        case ALG_AC:
+        case ALG_AC_DFA:
+        case ALG_AC_HYBRID:
+        case ALG_AC_DA:
+            ac_search(m->ac, (const char *)data, len, s, on_match, ctx);
+            break;
+        case ALG_WM_DET:
+        case ALG_WM_PROB:
+            wm_search(data, (int)len, m->ps, m->wm, s, on_match, ctx);
+            break;
+        case ALG_SH: {
+            s->algorithm_name = "Set–Horspool";
+            s->file_size += (uint64_t)len;
+            if (!m->sh_shift) break;
+
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            setHorspoolSearch((const char *)data, (uint64_t)len, m->sh_patterns,
+                              m->ps->pattern_count, m->sh_shift, m->sh_min_length,
+                              m->sh_hash, s, on_match, ctx);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            s->elapsed_sec += (double)(end.tv_sec - start.tv_sec) +
+                              (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+            break;
+        }
+        case ALG_BM:
+            bm_search(m->bm, (const char *)data, len, s, on_match, ctx);
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Begin scanning a new stream with matcher m
+ * --------------------------------------------------------------- */
+void matcher_stream_init(MatcherStream *st, const Matcher *m) {
+    memset(st, 0, sizeof(*st));
+    st->m = m;
+    switch (m->alg) {
+        case ALG_AC:
+        case ALG_AC_DFA:
+        case ALG_AC_HYBRID:
+        case ALG_AC_DA:
+            ac_stream_init(&st->ac);
+            break;
+        case ALG_WM_DET:
+        case ALG_WM_PROB:
+            wm_stream_init(&st->wm, m->ps, m->wm);
+            break;
+        case ALG_SH:
+            if (m->sh_shift)
+                setHorspoolStreamInit(&st->sh, m->sh_patterns, m->ps->pattern_count,
+                                      m->sh_shift, m->sh_min_length, m->sh_hash);
+            break;
+        case ALG_BM:
+            bm_stream_init(&st->bm, m->bm);
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Whether the engine's stream state is a single automaton state
+ *   (see matcher_scan_from)
+ * --------------------------------------------------------------- */
+int matcher_resumable(const Matcher *m) {
+    return m->alg == ALG_AC || m->alg == ALG_AC_DFA || m->alg == ALG_AC_HYBRID ||
+           m->alg == ALG_AC_DA;
+}
+
+/* ---------------------------------------------------------------
+ *   Resumable scan for matcher_resumable engines: continue a
+ *   stream from `state` (0 at its start), report match ends offset
+ *   by base, and return the state to resume the next buffer from
+ * --------------------------------------------------------------- */
+uint32_t matcher_scan_from(const Matcher *m, uint32_t state,
+                           const unsigned char *data, size_t len, uint64_t base,
+                           AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    return (uint32_t)ac_search_from(m->ac, (int)state, (const char *)data, len,
+                                    base, s, on_match, ctx);
+}
+
+/* ---------------------------------------------------------------
+ *   Scan the next len bytes of the stream; matches that span the
+ *   previous chunk are reported once, at their stream offset
+ * --------------------------------------------------------------- */
+void matcher_stream_feed(MatcherStream *st, const unsigned char *data, size_t len,
+                         AlgorithmStats *s, MatchCallback on_match, void *ctx) {
+    const Matcher *m = st->m;
+    switch (m->alg) {
+        case ALG_AC:
+        case ALG_AC_DFA:
+        case ALG_AC_HYBRID:
+        case ALG_AC_DA:
+            ac_stream_feed(m->ac, &st->ac, (const char *)data, len, s, on_match, ctx);
+            break;
+        case ALG_WM_DET:
+        case ALG_WM_PROB:
+            wm_stream_feed(&st->wm, data, len, s, on_match, ctx);
+            break;
+        case ALG_SH: {
+            s->algorithm_name = "Set–Horspool";
+            s->file_size += (uint64_t)len;
+            if (!m->sh_shift) break;
+
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            setHorspoolStreamFeed(&st->sh, (const char *)data, len, s, on_match, ctx);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            s->elapsed_sec += (double)(end.tv_sec - start.tv_sec) +
+                              (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+            break;
+        }
+        case ALG_BM:
+            bm_stream_feed(&st->bm, (const char *)data, len, s, on_match, ctx);
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *          End a stream and release its carried state
+ * --------------------------------------------------------------- */
+void matcher_stream_finish(MatcherStream *st) {
+    switch (st->m->alg) {
+        case ALG_AC:
+        case ALG_AC_DFA:
+        case ALG_AC_HYBRID:
+        case ALG_AC_DA:
+            ac_stream_finish(&st->ac);
+            break;
+        case ALG_WM_DET:
+        case ALG_WM_PROB:
+            wm_stream_finish(&st->wm);
+            break;
+        case ALG_SH:
+            setHorspoolStreamFinish(&st->sh);
+            break;
+        case ALG_BM:
+            bm_stream_finish(&st->bm);
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *            Release the engine owned by a Matcher
+ * --------------------------------------------------------------- */
+void matcher_destroy(Matcher *m) {
+    if (!m) return;
+    if (m->ac) ac_destroy(m->ac);
+    if (m->wm) {
+        wm_free_tables(m->wm);
+        track_free(m->wm);
+    }
+    if (m->sh_patterns) track_free(m->sh_patterns);
+    if (m->sh_hash) {
+        freePatternHashTable(m->sh_hash);
+        track_free(m->sh_hash);
+    }
+    if (m->sh_shift) track_free(m->sh_shift);
+    if (m->bm) bm_free_tables(m->bm);
+    track_free(m);
+}
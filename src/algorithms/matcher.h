@@ -0,0 +1,86 @@
+#ifndef SRC_ALGORITHMS_MATCHER_H_
+#define SRC_ALGORITHMS_MATCHER_H_
+
+#include <stddef.h>
+
+#include "match.h"
+#include "WM/wm.h"
+#include "AC/ac.h"
+#include "SH/sh.h"
+#include "BM/bm.h"
+
+/* ---------------------------------------------------------------
+ *                        Algorithm selection
+ * --------------------------------------------------------------- */
+typedef enum {
+    ALG_WM_DET,     // Wu–Manber deterministic
+    ALG_WM_PROB,    // Wu–Manber probabilistic
+    ALG_AC,         // Aho–Corasick
+    ALG_SH,         // Set–Horspool
+    ALG_BM,         // Boyer-Moore
+    ALG_AC_DFA,     // Aho–Corasick, full DFA layout
+    ALG_AC_HYBRID,  // Aho–Corasick, dense/sparse hybrid layout
+    ALG_AC_DA       // Aho–Corasick, double-array trie layout
+} AlgorithmType;
+
+/* ---------------------------------------------------------------
+ * Matcher:
+ *   One compiled multi-pattern engine over a PatternSet, behind a
+ *   single build/scan/destroy interface so callers can hold one
+ *   engine instance per rule group without caring which algorithm
+ *   it is. Only the members for `alg` are set. The PatternSet is
+ *   borrowed and must outlive the matcher. Scans add their
+ *   counters to a caller-owned AlgorithmStats, so one matcher can
+ *   be shared by several scanning threads.
+ * --------------------------------------------------------------- */
+typedef struct {
+    AlgorithmType     alg;
+    PatternSet       *ps;
+    WuManberTables   *wm;
+    AhoCorasick      *ac;
+    Pattern          *sh_patterns;
+    int              *sh_shift;
+    PatternList      *sh_hash;
+    int               sh_min_length;
+    BMPatterns       *bm;
+} Matcher;
+
+/* ---------------------------------------------------------------
+ * MatcherStream:
+ *   A scan of one logical stream fed in chunks through a Matcher.
+ *   Only the member for the matcher's algorithm is live: the
+ *   automaton state for Aho–Corasick, a bounded tail of the stream
+ *   for the skip-based engines. They share storage, so a stream
+ *   costs no more than its largest engine state. Match ends are
+ *   stream offsets. Engines for which matcher_resumable holds can
+ *   instead be driven with matcher_scan_from, whose whole stream
+ *   state is one 32-bit value kept by the caller.
+ * --------------------------------------------------------------- */
+typedef struct {
+    const Matcher     *m;
+    union {
+        ACStream           ac;
+        WMStream           wm;
+        SetHorspoolStream  sh;
+        BMStream           bm;
+    };
+} MatcherStream;
+
+/* ---------------------------------------------------------------
+ *                         Matcher API
+ * --------------------------------------------------------------- */
+const char *matcher_name(AlgorithmType alg);
+Matcher *matcher_create(AlgorithmType alg, PatternSet *ps);
+void matcher_scan(const Matcher *m, const unsigned char *data, size_t len,
+                  AlgorithmStats *s, MatchCallback on_match, void *ctx);
+int  matcher_resumable(const Matcher *m);
+uint32_t matcher_scan_from(const Matcher *m, uint32_t state,
+                           const unsigned char *data, size_t len, uint64_t base,
+                           AlgorithmStats *s, MatchCallback on_match, void *ctx);
+void matcher_stream_init(MatcherStream *st, const Matcher *m);
+void matcher_stream_feed(MatcherStream *st, const unsigned char *data, size_t len,
+                         AlgorithmStats *s, MatchCallback on_match, void *ctx);
+void matcher_stream_finish(MatcherStream *st);
+void matcher_destroy(Matcher *m);
+
+#endif  // SRC_ALGORITHMS_MATCHER_H_
@@ -0,0 +1,94 @@
+/*
+ *              Chunked Scanning for Skip-Based Engines
+ *
+ * ---------------------------------------------------------------
+ * Lets Wu–Manber, Set–Horspool and Boyer-Moore scan a stream fed
+ * in arbitrary chunks without missing matches that straddle a
+ * chunk boundary, while keeping only a bounded tail of the stream.
+ * Match ends are reported as stream offsets.
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stream.h"
+
+/* ---------------------------------------------------------------
+ *   Forwards matches ending in (min_end, max_end] of the scanned
+ *   buffer, shifted to stream offsets
+ * --------------------------------------------------------------- */
+typedef struct {
+    MatchCallback on_match;
+    void         *ctx;
+    uint64_t      base;
+    uint64_t      min_end;
+    uint64_t      max_end;
+} CarryFilter;
+
+static void carry_filter_hit(int pattern_id, uint64_t end, void *arg) {
+    const CarryFilter *f = arg;
+    if (end <= f->min_end || end > f->max_end) return;
+    if (f->on_match) f->on_match(pattern_id, f->base + end, f->ctx);
+}
+
+/* ---------------------------------------------------------------
+ *   Prepare to carry max_pattern_len - 1 bytes between chunks
+ * --------------------------------------------------------------- */
+void stream_carry_init(StreamCarry *c, int max_pattern_len) {
+    c->keep = max_pattern_len > 1 ? (size_t)max_pattern_len - 1 : 0;
+    c->tail_len = 0;
+    c->offset = 0;
+    c->buf = NULL;
+    if (c->keep == 0) return;
+
+    c->buf = track_malloc(2 * c->keep);
+    if (!c->buf) {
+        fprintf(stderr, "Memory allocation failed for stream carry buffer\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Scan the next len bytes of the stream
+ * --------------------------------------------------------------- */
+void stream_carry_feed(StreamCarry *c, const unsigned char *text, size_t len,
+                       StreamScanFn scan, const void *engine, AlgorithmStats *s,
+                       MatchCallback on_match, void *ctx) {
+    if (!text || len == 0) return;
+
+    size_t head = len < c->keep ? len : c->keep;
+    if (c->tail_len > 0) {
+        // Boundary: carried tail followed by the start of the chunk
+        memcpy(c->buf + c->tail_len, text, head);
+        CarryFilter f = { on_match, ctx, c->offset - c->tail_len,
+                          c->tail_len, c->tail_len + head };
+        scan(engine, c->buf, c->tail_len + head, s, carry_filter_hit, &f);
+    }
+
+    CarryFilter f = { on_match, ctx, c->offset, c->tail_len > 0 ? head : 0, len };
+    scan(engine, text, len, s, carry_filter_hit, &f);
+
+    // Keep the last `keep` bytes of the stream for the next chunk
+    if (len >= c->keep) {
+        if (c->keep) memcpy(c->buf, text + len - c->keep, c->keep);
+        c->tail_len = c->keep;
+    } else {
+        size_t total = c->tail_len + len;
+        size_t drop = total > c->keep ? total - c->keep : 0;
+        memmove(c->buf, c->buf + drop, c->tail_len - drop);
+        memcpy(c->buf + c->tail_len - drop, text, len);
+        c->tail_len = total - drop;
+    }
+    c->offset += (uint64_t)len;
+}
+
+/* ---------------------------------------------------------------
+ *   End the stream and release the carry buffer
+ * --------------------------------------------------------------- */
+void stream_carry_finish(StreamCarry *c) {
+    track_free(c->buf);
+    c->buf = NULL;
+    c->tail_len = 0;
+    c->offset = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef SRC_ALGORITHMS_STREAM_H_
+#define SRC_ALGORITHMS_STREAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "match.h"
+#include "../parse/analytics.h"
+
+/* ---------------------------------------------------------------
+ *   Whole-buffer scan of an engine that keeps no state between
+ *   calls; engine is the engine's own stream record
+ * --------------------------------------------------------------- */
+typedef void (*StreamScanFn)(const void *engine, const unsigned char *text, size_t len,
+                             AlgorithmStats *s, MatchCallback on_match, void *ctx);
+
+/* ---------------------------------------------------------------
+ * StreamCarry:
+ *   Chunk boundary handling for the skip-based engines (WM, SH,
+ *   BM), which cannot suspend mid-scan. The last keep = longest
+ *   pattern - 1 bytes of the stream are carried over; on the next
+ *   feed the carried tail plus the first keep bytes of the chunk
+ *   are scanned in a small boundary buffer, and the chunk itself
+ *   is scanned in place. Each match is reported once, by the scan
+ *   in which it ends: the boundary scan reports ends inside the
+ *   chunk's first keep bytes, the in-place scan the rest. Memory
+ *   is 2 * keep bytes regardless of stream length.
+ * --------------------------------------------------------------- */
+typedef struct {
+    unsigned char *buf;
+    size_t         tail_len;
+    size_t         keep;
+    uint64_t       offset;
+} StreamCarry;
+
+/* ---------------------------------------------------------------
+ *                      Stream Carry API
+ * --------------------------------------------------------------- */
+void stream_carry_init(StreamCarry *c, int max_pattern_len);
+void stream_carry_feed(StreamCarry *c, const unsigned char *text, size_t len,
+                       StreamScanFn scan, const void *engine, AlgorithmStats *s,
+                       MatchCallback on_match, void *ctx);
+void stream_carry_finish(StreamCarry *c);
+
+#endif  // SRC_ALGORITHMS_STREAM_H_
@@ -0,0 +1,72 @@
+/*
+ *                   Memory-Mapped Capture Input
+ *
+ * ---------------------------------------------------------------
+ * Maps a capture file read-only instead of reading it into a heap
+ * buffer, so scanning needs no copy and no memory beyond the page
+ * cache, and captures larger than RAM can be processed. The
+ * kernel is told the access is sequential so it reads ahead
+ * aggressively and drops pages behind the scan.
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "captureFile.h"
+
+/* ---------------------------------------------------------------
+ *   Map the regular file at path. Returns 0 on success, -1 if it
+ *   cannot be opened or mapped (or is empty or not a file).
+ * --------------------------------------------------------------- */
+int openCaptureFile(const char *path, int flags, CaptureFile *out) {
+    out->data = NULL;
+    out->len = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        fprintf(stderr, "[-] %s: not a non-empty regular file\n", path);
+        close(fd);
+        return -1;
+    }
+
+    int map_flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (flags & CAPTURE_MAP_POPULATE) map_flags |= MAP_POPULATE;
+#endif
+
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, map_flags, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    // Hints only: failures are harmless
+    madvise(map, len, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    if (flags & CAPTURE_MAP_HUGEPAGES) madvise(map, len, MADV_HUGEPAGE);
+#endif
+
+    out->data = map;
+    out->len = len;
+    return 0;
+}
+
+/* ---------------------------------------------------------------
+ *                     Unmap a capture file
+ * --------------------------------------------------------------- */
+void closeCaptureFile(CaptureFile *f) {
+    if (f->data) munmap((void *)f->data, f->len);
+    f->data = NULL;
+    f->len = 0;
+}
@@ -0,0 +1,29 @@
+#ifndef SRC_CAPTURE_CAPTUREFILE_H_
+#define SRC_CAPTURE_CAPTUREFILE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ---------------------------------------------------------------
+ *   Optional mapping hints for openCaptureFile
+ * --------------------------------------------------------------- */
+#define CAPTURE_MAP_POPULATE   0x1   // prefault the whole file up front
+#define CAPTURE_MAP_HUGEPAGES  0x2   // ask for transparent huge pages
+
+/* ---------------------------------------------------------------
+ * CaptureFile:
+ *   A capture mapped read-only into memory. Packet data is read
+ *   straight from the page cache; nothing is copied.
+ * --------------------------------------------------------------- */
+typedef struct {
+    const uint8_t *data;
+    size_t         len;
+} CaptureFile;
+
+/* ---------------------------------------------------------------
+ *                     Capture File API
+ * --------------------------------------------------------------- */
+int  openCaptureFile(const char *path, int flags, CaptureFile *out);
+void closeCaptureFile(CaptureFile *f);
+
+#endif  // SRC_CAPTURE_CAPTUREFILE_H_
@@ -0,0 +1,50 @@
+/*
+ *                     Capture Format Dispatch
+ *
+ * ---------------------------------------------------------------
+ * Recognises classic pcap and pcapng captures by their magic
+ * number and hands packets out through one interface, so the
+ * packet pipeline does not care which format a file is in.
+ * --------------------------------------------------------------- */
+
+#include "captureReader.h"
+
+/* ---------------------------------------------------------------
+ *   Open data with the first reader that accepts it. Returns 0 on
+ *   success, -1 if it is not a capture in a supported format.
+ * --------------------------------------------------------------- */
+int openCaptureReader(CaptureReader *r, const uint8_t *data, size_t len) {
+    if (openPcapReader(&r->pcap, data, len) == 0) {
+        r->format = CAPTURE_FORMAT_PCAP;
+        return 0;
+    }
+    if (openPcapngReader(&r->pcapng, data, len) == 0) {
+        r->format = CAPTURE_FORMAT_PCAPNG;
+        return 0;
+    }
+    r->format = 0;
+    return -1;
+}
+
+/* ---------------------------------------------------------------
+ *   Advance to the next packet. Returns 1 with pkt filled in, 0 at
+ *   the end of the capture, or -1 if the capture is truncated.
+ * --------------------------------------------------------------- */
+int nextCapturePacket(CaptureReader *r, PcapPacket *pkt) {
+    switch (r->format) {
+        case CAPTURE_FORMAT_PCAP:   return nextPcapPacket(&r->pcap, pkt);
+        case CAPTURE_FORMAT_PCAPNG: return nextPcapngPacket(&r->pcapng, pkt);
+        default:                    return 0;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *               Human-readable name of the format
+ * --------------------------------------------------------------- */
+const char *captureFormatName(const CaptureReader *r) {
+    switch (r->format) {
+        case CAPTURE_FORMAT_PCAP:   return "pcap";
+        case CAPTURE_FORMAT_PCAPNG: return "pcapng";
+        default:                    return "raw";
+    }
+}
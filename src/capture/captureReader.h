@@ -0,0 +1,36 @@
+#ifndef SRC_CAPTURE_CAPTUREREADER_H_
+#define SRC_CAPTURE_CAPTUREREADER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "pcapReader.h"
+#include "pcapngReader.h"
+
+/* ---------------------------------------------------------------
+ *   Capture file formats
+ * --------------------------------------------------------------- */
+#define CAPTURE_FORMAT_PCAP    1
+#define CAPTURE_FORMAT_PCAPNG  2
+
+/* ---------------------------------------------------------------
+ * CaptureReader:
+ *   Packet iterator over an in-memory capture in any supported
+ *   format, chosen from the file's leading magic number.
+ * --------------------------------------------------------------- */
+typedef struct {
+    int format;
+    union {
+        PcapReader   pcap;
+        PcapngReader pcapng;
+    };
+} CaptureReader;
+
+/* ---------------------------------------------------------------
+ *                    Capture Reader API
+ * --------------------------------------------------------------- */
+int openCaptureReader(CaptureReader *r, const uint8_t *data, size_t len);
+int nextCapturePacket(CaptureReader *r, PcapPacket *pkt);
+const char *captureFormatName(const CaptureReader *r);
+
+#endif  // SRC_CAPTURE_CAPTUREREADER_H_
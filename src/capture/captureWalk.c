@@ -0,0 +1,97 @@
+/*
+ *                 Decoded Packets of a Capture Tree
+ *
+ * ---------------------------------------------------------------
+ * Feeds every decodable packet of a capture file, or of every
+ * .pcap / .pcapng file below a directory, to a callback. Each
+ * directory is read in name order (scandir + alphasort), so a
+ * walk cut short by its callback always covers the same files
+ * whatever order the filesystem lists them in.
+ * --------------------------------------------------------------- */
+
+// Define the POSIX source to have access to scandir and alphasort
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "captureWalk.h"
+#include "captureFile.h"
+#include "captureReader.h"
+
+/* ---------------------------------------------------------------
+ *   Feed the packets of one capture. Returns 0 once fn stops the
+ *   walk, 1 otherwise (also for files that are not captures).
+ * --------------------------------------------------------------- */
+static int walkCaptureFile(const char *path, CapturePacketFn fn, void *ctx) {
+    CaptureFile file;
+    if (openCaptureFile(path, 0, &file) != 0) return 1;
+
+    int more = 1;
+    CaptureReader reader;
+    if (openCaptureReader(&reader, file.data, file.len) == 0) {
+        PcapPacket pkt;
+        DecodedPacket dp;
+        while (more && nextCapturePacket(&reader, &pkt) == 1) {
+            if (decodePacket(pkt.linktype, pkt.data, pkt.caplen, &dp))
+                more = fn(&dp, ctx);
+        }
+    }
+    closeCaptureFile(&file);
+    return more;
+}
+
+/* ---------------------------------------------------------------
+ *   Walk one directory in name order, descending into
+ *   subdirectories. Returns 0 once fn stops the walk.
+ * --------------------------------------------------------------- */
+static int walkCaptureDir(const char *base_path, CapturePacketFn fn, void *ctx) {
+    struct dirent **entries;
+    int n = scandir(base_path, &entries, NULL, alphasort);
+    if (n < 0) {
+        perror(base_path);
+        return 1;
+    }
+
+    int more = 1;
+    char path[4096];
+    for (int i = 0; i < n; i++) {
+        const char *name = entries[i]->d_name;
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", base_path, name);
+        if (more && name[0] != '.' && stat(path, &st) == 0) {
+            const char *ext = strrchr(name, '.');
+            if (S_ISDIR(st.st_mode))
+                more = walkCaptureDir(path, fn, ctx);
+            else if (S_ISREG(st.st_mode) && ext &&
+                     (strcmp(ext, ".pcap") == 0 || strcmp(ext, ".pcapng") == 0))
+                more = walkCaptureFile(path, fn, ctx);
+        }
+        free(entries[i]);
+    }
+    free(entries);
+    return more;
+}
+
+/* ---------------------------------------------------------------
+ *   Call fn with every decoded packet of the capture at path, or
+ *   of the captures below it if it is a directory, until fn
+ *   returns 0. Returns 0, or -1 if path does not exist.
+ * --------------------------------------------------------------- */
+int walkCapturePackets(const char *path, CapturePacketFn fn, void *ctx) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return -1;
+    }
+    if (S_ISDIR(st.st_mode))
+        walkCaptureDir(path, fn, ctx);
+    else
+        walkCaptureFile(path, fn, ctx);
+    return 0;
+}
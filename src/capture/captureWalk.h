@@ -0,0 +1,18 @@
+#ifndef SRC_CAPTURE_CAPTUREWALK_H_
+#define SRC_CAPTURE_CAPTUREWALK_H_
+
+#include "packetDecode.h"
+
+/* ---------------------------------------------------------------
+ * CapturePacketFn:
+ *   Called with each decoded packet of a capture walk. Returning
+ *   0 stops the walk.
+ * --------------------------------------------------------------- */
+typedef int (*CapturePacketFn)(const DecodedPacket *dp, void *ctx);
+
+/* ---------------------------------------------------------------
+ *                     Capture Walk API
+ * --------------------------------------------------------------- */
+int walkCapturePackets(const char *path, CapturePacketFn fn, void *ctx);
+
+#endif  // SRC_CAPTURE_CAPTUREWALK_H_
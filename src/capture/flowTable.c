@@ -0,0 +1,423 @@
+/*
+ *                          Flow Table
+ *
+ * ---------------------------------------------------------------
+ * Tracks live connections by their direction-independent 5-tuple
+ * so that per-flow state (TCP sequence tracking, buffered
+ * segments, the matcher's stream state) survives from one packet
+ * to the next, at millions of concurrent flows:
+ *
+ *   index   open addressing in the style of Abseil's Swiss table:
+ *           a control byte per slot holds 7 bits of the hash, and
+ *           a probe tests 16 control bytes with one SSE2 compare
+ *           (a scalar loop elsewhere) before touching any flow.
+ *           Probing steps over aligned groups with triangular
+ *           increments and stops at the first group with an
+ *           empty slot.
+ *   storage every Flow lives in a pool allocated once for
+ *           max_flows records; pages are only touched as records
+ *           are first used, and nothing is allocated per packet.
+ *   expiry  a timer wheel of FLOW_WHEEL_SLOTS one-second slots.
+ *           A flow is linked into the slot of its expiry tick and
+ *           moved when it is seen in a later tick, so expiring a
+ *           tick or finding the least recently seen flow to evict
+ *           never scans the table.
+ *
+ * Reference:
+ *   M. Kulukundis, "Designing a Fast, Efficient, Cache-friendly
+ *   Hash Table, Step by Step," CppCon 2017.
+ *   G. Varghese, T. Lauck, "Hashed and Hierarchical Timing Wheels,"
+ *   SOSP 1987.
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "flowTable.h"
+
+#define FLOW_CTRL_EMPTY    ((int8_t)-128)
+#define FLOW_CTRL_DELETED  ((int8_t)-2)
+
+_Static_assert(sizeof(FlowKey) == 40, "FlowKey must pack into five 64-bit words");
+
+/* ---------------------------------------------------------------
+ *   Mix the five key words into a 64-bit hash: the low 7 bits are
+ *   the control tag, the rest pick the first group to probe
+ * --------------------------------------------------------------- */
+static uint64_t hashFlowKey(const FlowKey *k) {
+    uint64_t w[5];
+    memcpy(w, k, sizeof(w));
+    uint64_t h = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 5; i++) {
+        h ^= w[i];
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 29;
+    }
+    h *= 0x94D049BB133111EBull;
+    return h ^ (h >> 32);
+}
+
+static int8_t hashTag(uint64_t h) {
+    return (int8_t)(h & 0x7F);
+}
+
+/* ---------------------------------------------------------------
+ *   Bit i set where control byte i of the group equals tag
+ * --------------------------------------------------------------- */
+static uint32_t groupMatch(const int8_t *group, int8_t tag) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)(const void *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < FLOW_GROUP_WIDTH; i++)
+        if (group[i] == tag) mask |= 1u << i;
+    return mask;
+#endif
+}
+
+/* ---------------------------------------------------------------
+ *   Bit i set where slot i of the group is empty or deleted (the
+ *   only control values with the sign bit set)
+ * --------------------------------------------------------------- */
+static uint32_t groupMatchFree(const int8_t *group) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)(const void *)group);
+    return (uint32_t)_mm_movemask_epi8(ctrl);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < FLOW_GROUP_WIDTH; i++)
+        if (group[i] < 0) mask |= 1u << i;
+    return mask;
+#endif
+}
+
+/* ---------------------------------------------------------------
+ *   Build the key of dp's flow. Returns the key endpoint (0 or 1)
+ *   that sent dp.
+ * --------------------------------------------------------------- */
+static int makeFlowKey(const DecodedPacket *dp, FlowKey *k) {
+    memset(k, 0, sizeof(*k));
+    k->ip_version = dp->ip_version;
+    k->ip_proto = dp->ip_proto;
+
+    int cmp = memcmp(dp->src_addr, dp->dst_addr, sizeof(dp->src_addr));
+    if (cmp == 0) cmp = (int)dp->src_port - (int)dp->dst_port;
+    int sender = cmp <= 0 ? 0 : 1;
+
+    memcpy(k->addr[sender], dp->src_addr, sizeof(dp->src_addr));
+    memcpy(k->addr[1 - sender], dp->dst_addr, sizeof(dp->dst_addr));
+    k->port[sender] = dp->src_port;
+    k->port[1 - sender] = dp->dst_port;
+    return sender;
+}
+
+/* ---------------------------------------------------------------
+ *   Empty table able to hold max_flows flows, expiring those idle
+ *   for idle_timeout_ns (rounded up to whole ticks, at most the
+ *   wheel's span)
+ * --------------------------------------------------------------- */
+FlowTable *createFlowTable(size_t max_flows, uint64_t idle_timeout_ns,
+                           FlowReleaseFn release, void *ctx) {
+    FlowTable *t = calloc(1, sizeof(FlowTable));
+    if (!t) {
+        fprintf(stderr, "Memory allocation failed for FlowTable.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (max_flows == 0) max_flows = 1;
+    if (max_flows >= FLOW_NONE) max_flows = FLOW_NONE - 1;
+
+    // Keep the index at most 7/8 full with every pool record live
+    size_t cap = FLOW_GROUP_WIDTH;
+    while (cap / 8 * 7 <= max_flows) cap <<= 1;
+
+    t->ctrl = malloc(cap);
+    t->index = malloc(cap * sizeof(uint32_t));
+    t->pool = calloc(max_flows, sizeof(Flow));
+    if (!t->ctrl || !t->index || !t->pool) {
+        fprintf(stderr, "Memory allocation failed for FlowTable.\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(t->ctrl, FLOW_CTRL_EMPTY, cap);
+    t->capacity = cap;
+    t->max_flows = max_flows;
+    t->pool_free = FLOW_NONE;
+
+    for (int s = 0; s < FLOW_WHEEL_SLOTS; s++) {
+        t->wheel_head[s] = FLOW_NONE;
+        t->wheel_tail[s] = FLOW_NONE;
+    }
+    uint64_t ticks = (idle_timeout_ns + FLOW_TICK_NS - 1) / FLOW_TICK_NS;
+    if (ticks < 1) ticks = 1;
+    if (ticks > FLOW_WHEEL_SLOTS - 1) ticks = FLOW_WHEEL_SLOTS - 1;
+    t->timeout_ticks = (uint32_t)ticks;
+
+    t->release = release;
+    t->release_ctx = ctx;
+    return t;
+}
+
+/* ---------------------------------------------------------------
+ *   Find the flow with key k (hash h), or NULL
+ * --------------------------------------------------------------- */
+static Flow *findFlow(const FlowTable *t, const FlowKey *k, uint64_t h) {
+    size_t group_mask = t->capacity / FLOW_GROUP_WIDTH - 1;
+    size_t g = (size_t)(h >> 7) & group_mask;
+    int8_t tag = hashTag(h);
+
+    for (size_t step = 1; step <= group_mask + 1; step++) {
+        const int8_t *group = t->ctrl + g * FLOW_GROUP_WIDTH;
+        uint32_t hits = groupMatch(group, tag);
+        while (hits) {
+            size_t slot = g * FLOW_GROUP_WIDTH + (size_t)__builtin_ctz(hits);
+            Flow *f = &t->pool[t->index[slot]];
+            if (memcmp(&f->key, k, sizeof(*k)) == 0) return f;
+            hits &= hits - 1;
+        }
+        if (groupMatch(group, FLOW_CTRL_EMPTY)) return NULL;
+        g = (g + step) & group_mask;
+    }
+    return NULL;
+}
+
+/* ---------------------------------------------------------------
+ *   Claim the first free slot on h's probe sequence for pool
+ *   record idx and return it
+ * --------------------------------------------------------------- */
+static uint32_t claimSlot(FlowTable *t, uint64_t h, uint32_t idx) {
+    size_t group_mask = t->capacity / FLOW_GROUP_WIDTH - 1;
+    size_t g = (size_t)(h >> 7) & group_mask;
+    for (size_t step = 1;; step++) {
+        uint32_t free_mask = groupMatchFree(t->ctrl + g * FLOW_GROUP_WIDTH);
+        if (free_mask) {
+            size_t slot = g * FLOW_GROUP_WIDTH + (size_t)__builtin_ctz(free_mask);
+            if (t->ctrl[slot] == FLOW_CTRL_DELETED) t->tombstones--;
+            t->ctrl[slot] = hashTag(h);
+            t->index[slot] = idx;
+            return (uint32_t)slot;
+        }
+        g = (g + step) & group_mask;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Free a slot. It can go straight back to empty if its group
+ *   still has an empty slot, since then no probe ever passed
+ *   through the group; otherwise it must stay a tombstone.
+ * --------------------------------------------------------------- */
+static void releaseSlot(FlowTable *t, uint32_t slot) {
+    const int8_t *group = t->ctrl + (slot / FLOW_GROUP_WIDTH) * FLOW_GROUP_WIDTH;
+    if (groupMatch(group, FLOW_CTRL_EMPTY)) {
+        t->ctrl[slot] = FLOW_CTRL_EMPTY;
+    } else {
+        t->ctrl[slot] = FLOW_CTRL_DELETED;
+        t->tombstones++;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Rebuild the index in place from the live flows, dropping
+ *   every tombstone. Flows do not move.
+ * --------------------------------------------------------------- */
+static void rehashFlows(FlowTable *t) {
+    memset(t->ctrl, FLOW_CTRL_EMPTY, t->capacity);
+    t->tombstones = 0;
+    for (size_t i = 0; i < t->pool_used; i++) {
+        Flow *f = &t->pool[i];
+        if (f->in_use) f->slot = claimSlot(t, hashFlowKey(&f->key), (uint32_t)i);
+    }
+}
+
+/* ---------------------------------------------------------------
+ *            Timer wheel: link / unlink a flow
+ * --------------------------------------------------------------- */
+static void wheelLink(FlowTable *t, Flow *f, uint32_t idx) {
+    uint32_t s = f->expiry_tick & (FLOW_WHEEL_SLOTS - 1);
+    f->wheel_prev = t->wheel_tail[s];
+    f->wheel_next = FLOW_NONE;
+    if (t->wheel_tail[s] != FLOW_NONE) t->pool[t->wheel_tail[s]].wheel_next = idx;
+    else t->wheel_head[s] = idx;
+    t->wheel_tail[s] = idx;
+}
+
+static void wheelUnlink(FlowTable *t, Flow *f) {
+    uint32_t s = f->expiry_tick & (FLOW_WHEEL_SLOTS - 1);
+    if (f->wheel_prev != FLOW_NONE) t->pool[f->wheel_prev].wheel_next = f->wheel_next;
+    else t->wheel_head[s] = f->wheel_next;
+    if (f->wheel_next != FLOW_NONE) t->pool[f->wheel_next].wheel_prev = f->wheel_prev;
+    else t->wheel_tail[s] = f->wheel_prev;
+}
+
+/* ---------------------------------------------------------------
+ *   Record that f was seen at now_ns, moving it to the wheel slot
+ *   of its new expiry tick if that changed
+ * --------------------------------------------------------------- */
+static void touchFlow(FlowTable *t, Flow *f, uint64_t now_ns) {
+    f->last_seen_ns = now_ns;
+    uint64_t tick = now_ns / FLOW_TICK_NS;
+    if (tick < t->now_tick) tick = t->now_tick;
+    uint32_t expiry = (uint32_t)(tick + t->timeout_ticks);
+    if (expiry == f->expiry_tick) return;
+
+    wheelUnlink(t, f);
+    f->expiry_tick = expiry;
+    wheelLink(t, f, (uint32_t)(f - t->pool));
+}
+
+/* ---------------------------------------------------------------
+ *   Release a flow's consumer state and buffered segments and
+ *   return its record to the pool
+ * --------------------------------------------------------------- */
+void removeFlow(FlowTable *t, Flow *f) {
+    uint32_t idx = (uint32_t)(f - t->pool);
+    releaseSlot(t, f->slot);
+    wheelUnlink(t, f);
+    t->flow_count--;
+
+    if (t->release) t->release(f, t->release_ctx);
+    for (int d = 0; d < 2; d++) {
+        TcpSegment *seg = f->half[d].ooo;
+        while (seg) {
+            TcpSegment *next = seg->next;
+            free(seg);
+            seg = next;
+        }
+    }
+    memset(f, 0, sizeof(*f));
+    f->wheel_next = t->pool_free;
+    t->pool_free = idx;
+}
+
+/* ---------------------------------------------------------------
+ *   Pool full: evict the flow closest to expiry, i.e. the head of
+ *   the first non-empty wheel slot after the current tick
+ * --------------------------------------------------------------- */
+static void evictOldestFlow(FlowTable *t) {
+    for (uint32_t i = 1; i <= FLOW_WHEEL_SLOTS; i++) {
+        uint32_t s = (uint32_t)(t->now_tick + i) & (FLOW_WHEEL_SLOTS - 1);
+        if (t->wheel_head[s] != FLOW_NONE) {
+            t->evicted++;
+            removeFlow(t, &t->pool[t->wheel_head[s]]);
+            return;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Take a free pool record, evicting if none is left
+ * --------------------------------------------------------------- */
+static uint32_t allocFlow(FlowTable *t) {
+    if (t->pool_free == FLOW_NONE && t->pool_used == t->max_flows)
+        evictOldestFlow(t);
+
+    uint32_t idx;
+    if (t->pool_free != FLOW_NONE) {
+        idx = t->pool_free;
+        t->pool_free = t->pool[idx].wheel_next;
+    } else {
+        idx = (uint32_t)t->pool_used++;
+    }
+    return idx;
+}
+
+/* ---------------------------------------------------------------
+ *   Find dp's flow, creating it if `create` is set, and mark it
+ *   seen at now_ns. *dir is set to the FLOW_DIR_* of dp within
+ *   the flow. A flow first seen on a SYN-ACK is oriented with the
+ *   SYN-ACK's sender as the server. Returns NULL if the flow does
+ *   not exist and create is 0.
+ * --------------------------------------------------------------- */
+Flow *lookupFlow(FlowTable *t, const DecodedPacket *dp, uint64_t now_ns,
+                 int create, int *dir) {
+    FlowKey key;
+    int sender = makeFlowKey(dp, &key);
+    uint64_t h = hashFlowKey(&key);
+
+    Flow *f = findFlow(t, &key, h);
+    if (f) {
+        touchFlow(t, f, now_ns);
+        *dir = sender == f->client_end ? FLOW_DIR_CLIENT : FLOW_DIR_SERVER;
+        return f;
+    }
+    if (!create) return NULL;
+
+    uint32_t idx = allocFlow(t);
+    if ((t->flow_count + t->tombstones + 1) > t->capacity / 8 * 7) rehashFlows(t);
+
+    f = &t->pool[idx];
+    memset(f, 0, sizeof(*f));
+    f->key = key;
+    f->in_use = 1;
+    int synack = dp->ip_proto == IPPROTO_NUM_TCP &&
+                 (dp->tcp_flags & (TCP_FLAG_SYN | TCP_FLAG_ACK)) ==
+                 (TCP_FLAG_SYN | TCP_FLAG_ACK);
+    f->client_end = (uint8_t)(synack ? 1 - sender : sender);
+    f->slot = claimSlot(t, h, idx);
+    t->flow_count++;
+    t->created++;
+
+    uint64_t tick = now_ns / FLOW_TICK_NS;
+    if (tick < t->now_tick) tick = t->now_tick;
+    f->last_seen_ns = now_ns;
+    f->expiry_tick = (uint32_t)(tick + t->timeout_ticks);
+    wheelLink(t, f, idx);
+
+    *dir = sender == f->client_end ? FLOW_DIR_CLIENT : FLOW_DIR_SERVER;
+    return f;
+}
+
+/* ---------------------------------------------------------------
+ *   Move the clock to now_ns, expiring the flows of every tick
+ *   passed. A jump longer than the wheel visits each slot once.
+ * --------------------------------------------------------------- */
+void advanceFlowClock(FlowTable *t, uint64_t now_ns) {
+    uint64_t tick = now_ns / FLOW_TICK_NS;
+    if (!t->clock_started) {
+        t->clock_started = 1;
+        t->now_tick = tick;
+        return;
+    }
+    if (tick <= t->now_tick) return;
+
+    uint64_t steps = tick - t->now_tick;
+    if (steps > FLOW_WHEEL_SLOTS) steps = FLOW_WHEEL_SLOTS;
+    for (uint64_t i = 1; i <= steps; i++) {
+        uint32_t s = (uint32_t)(t->now_tick + i) & (FLOW_WHEEL_SLOTS - 1);
+        uint32_t idx = t->wheel_head[s];
+        while (idx != FLOW_NONE) {
+            Flow *f = &t->pool[idx];
+            idx = f->wheel_next;
+            if (f->expiry_tick <= (uint32_t)tick) {
+                t->expired++;
+                removeFlow(t, f);
+            }
+        }
+    }
+    t->now_tick = tick;
+}
+
+/* ---------------------------------------------------------------
+ *   Bytes reserved by the table: index, control bytes and pool
+ * --------------------------------------------------------------- */
+size_t flowTableBytes(const FlowTable *t) {
+    return sizeof(*t) + t->capacity * (1 + sizeof(uint32_t)) +
+           t->max_flows * sizeof(Flow);
+}
+
+/* ---------------------------------------------------------------
+ *          Release every remaining flow and the table
+ * --------------------------------------------------------------- */
+void freeFlowTable(FlowTable *t) {
+    if (!t) return;
+    for (size_t i = 0; i < t->pool_used; i++)
+        if (t->pool[i].in_use) removeFlow(t, &t->pool[i]);
+    free(t->ctrl);
+    free(t->index);
+    free(t->pool);
+    free(t);
+}
@@ -0,0 +1,143 @@
+#ifndef SRC_CAPTURE_FLOWTABLE_H_
+#define SRC_CAPTURE_FLOWTABLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "packetDecode.h"
+
+/* ---------------------------------------------------------------
+ *   Flow directions: the endpoint that sent the first packet seen
+ *   is the client
+ * --------------------------------------------------------------- */
+#define FLOW_DIR_CLIENT  0
+#define FLOW_DIR_SERVER  1
+
+#define FLOW_GROUP_WIDTH  16          // control bytes probed at once
+#define FLOW_WHEEL_SLOTS  512         // timer wheel size, in ticks
+#define FLOW_TICK_NS      1000000000ull
+#define FLOW_NONE         UINT32_MAX  // null pool index
+
+/* ---------------------------------------------------------------
+ * FlowKey:
+ *   Direction-independent 5-tuple. Endpoint 0 is the lower of the
+ *   two (address, port) pairs, so both directions of a connection
+ *   map to the same key. IPv4 addresses use the first 4 bytes.
+ *   Padded to 40 bytes so it hashes as five 64-bit words.
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint8_t  addr[2][16];
+    uint16_t port[2];
+    uint8_t  ip_version;
+    uint8_t  ip_proto;
+    uint16_t pad;
+} FlowKey;
+
+/* ---------------------------------------------------------------
+ * TcpSegment:
+ *   A copy of an out-of-order segment waiting for the gap before
+ *   it to fill. Kept in a list sorted by sequence number.
+ * --------------------------------------------------------------- */
+typedef struct TcpSegment {
+    struct TcpSegment *next;
+    uint32_t           seq;
+    uint32_t           len;
+    uint8_t            data[];
+} TcpSegment;
+
+/* ---------------------------------------------------------------
+ * FlowHalf:
+ *   One direction of a flow. next_seq is the sequence number of the
+ *   next in-order byte once seq_valid is set; delivered counts the
+ *   bytes handed on in order, i.e. the stream offset of next_seq.
+ *   `scan` is the consumer's per-direction state, released through
+ *   the table's FlowReleaseFn.
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint64_t    delivered;
+    TcpSegment *ooo;
+    void       *scan;
+    uint32_t    next_seq;
+    uint32_t    ooo_bytes;
+    uint8_t     seq_valid;
+    uint8_t     fin;
+} FlowHalf;
+
+/* ---------------------------------------------------------------
+ * Flow:
+ *   A bidirectional connection, living in the table's preallocated
+ *   pool (its address is stable until it is removed). client_end
+ *   is the key endpoint (0 or 1) that is FLOW_DIR_CLIENT.
+ *   wheel_prev/wheel_next link it into the timer-wheel slot of its
+ *   expiry tick; slot is its position in the hash index.
+ * --------------------------------------------------------------- */
+typedef struct {
+    FlowKey   key;
+    uint8_t   client_end;
+    uint8_t   in_use;
+    uint32_t  slot;
+    uint32_t  expiry_tick;
+    uint32_t  wheel_prev;
+    uint32_t  wheel_next;
+    uint64_t  last_seen_ns;
+    FlowHalf  half[2];
+} Flow;
+
+typedef void (*FlowReleaseFn)(Flow *f, void *ctx);
+
+/* ---------------------------------------------------------------
+ * FlowTable:
+ *   Open-addressing (Swiss table) index over a fixed pool of
+ *   max_flows Flow records. ctrl holds one byte per slot: the low
+ *   7 bits of the flow's hash, or FLOW_CTRL_EMPTY / _DELETED;
+ *   index holds the pool index. A probe compares a whole group of
+ *   FLOW_GROUP_WIDTH control bytes against the hash tag at once
+ *   (SSE2 where available) and only touches flows whose tag
+ *   matches, so a lookup costs about one cache line of control
+ *   bytes and one flow record.
+ *
+ *   Every flow sits on the timer wheel in the slot of the tick at
+ *   which it would expire. Advancing the clock expires whole slots;
+ *   when the pool is full the flow closest to expiry (the least
+ *   recently seen) is evicted. `release` is called for every flow
+ *   leaving the table, before its buffered segments are freed.
+ * --------------------------------------------------------------- */
+typedef struct {
+    int8_t        *ctrl;
+    uint32_t      *index;
+    size_t         capacity;
+    size_t         tombstones;
+
+    Flow          *pool;
+    size_t         max_flows;
+    size_t         pool_used;      // high-water mark: records ever handed out
+    uint32_t       pool_free;      // free list through wheel_next
+    size_t         flow_count;
+
+    uint32_t       wheel_head[FLOW_WHEEL_SLOTS];
+    uint32_t       wheel_tail[FLOW_WHEEL_SLOTS];
+    uint64_t       now_tick;
+    uint32_t       timeout_ticks;
+    int            clock_started;
+
+    uint64_t       created;
+    uint64_t       expired;
+    uint64_t       evicted;
+
+    FlowReleaseFn  release;
+    void          *release_ctx;
+} FlowTable;
+
+/* ---------------------------------------------------------------
+ *                       Flow Table API
+ * --------------------------------------------------------------- */
+FlowTable *createFlowTable(size_t max_flows, uint64_t idle_timeout_ns,
+                           FlowReleaseFn release, void *ctx);
+Flow  *lookupFlow(FlowTable *t, const DecodedPacket *dp, uint64_t now_ns,
+                  int create, int *dir);
+void   removeFlow(FlowTable *t, Flow *f);
+void   advanceFlowClock(FlowTable *t, uint64_t now_ns);
+size_t flowTableBytes(const FlowTable *t);
+void   freeFlowTable(FlowTable *t);
+
+#endif  // SRC_CAPTURE_FLOWTABLE_H_
@@ -0,0 +1,222 @@
+/*
+ *                  Link / Network / Transport Decoder
+ *
+ * ---------------------------------------------------------------
+ * Strips the protocol headers from a captured frame so that only
+ * the application payload is handed to the pattern matchers:
+ *   link      Ethernet (with 802.1Q / 802.1ad VLAN tags), Linux
+ *             cooked capture, BSD loopback and raw IP
+ *   network   IPv4 (options, padding) and IPv6 (extension headers)
+ *   transport TCP (options), UDP, ICMP / ICMPv6
+ * Non-first IP fragments carry no transport header and are not
+ * reassembled, so they are reported as undecodable. Every length
+ * is checked against the captured bytes, never trusted.
+ * --------------------------------------------------------------- */
+
+#include <string.h>
+
+#include "packetDecode.h"
+#include "pcapReader.h"
+
+#define ETHERTYPE_IPV4     0x0800
+#define ETHERTYPE_IPV6     0x86DD
+#define ETHERTYPE_VLAN     0x8100
+#define ETHERTYPE_QINQ     0x88A8
+#define ETHERTYPE_QINQ_OLD 0x9100
+
+#define ETH_HDR_LEN        14
+#define VLAN_TAG_LEN       4
+#define SLL_HDR_LEN        16
+#define NULL_HDR_LEN       4
+#define IPV4_MIN_HDR_LEN   20
+#define IPV6_HDR_LEN       40
+#define TCP_MIN_HDR_LEN    20
+#define UDP_HDR_LEN        8
+#define ICMP_HDR_LEN       8
+
+#define IPV6_MAX_EXT_HDRS  8
+
+static uint16_t readBE16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t readBE32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/* ---------------------------------------------------------------
+ *   Decode the transport header at p and locate the payload
+ * --------------------------------------------------------------- */
+static int decodeTransport(const uint8_t *p, uint32_t len, DecodedPacket *out) {
+    uint32_t hdr;
+    switch (out->ip_proto) {
+        case IPPROTO_NUM_TCP:
+            if (len < TCP_MIN_HDR_LEN) return 0;
+            hdr = (uint32_t)(p[12] >> 4) * 4u;
+            if (hdr < TCP_MIN_HDR_LEN || hdr > len) return 0;
+            out->src_port = readBE16(p);
+            out->dst_port = readBE16(p + 2);
+            out->tcp_seq = readBE32(p + 4);
+            out->tcp_flags = p[13];
+            break;
+
+        case IPPROTO_NUM_UDP: {
+            if (len < UDP_HDR_LEN) return 0;
+            uint16_t udp_len = readBE16(p + 4);
+            if (udp_len >= UDP_HDR_LEN && udp_len < len) len = udp_len;
+            hdr = UDP_HDR_LEN;
+            out->src_port = readBE16(p);
+            out->dst_port = readBE16(p + 2);
+            break;
+        }
+
+        case IPPROTO_NUM_ICMP:
+        case IPPROTO_NUM_ICMPV6:
+            if (len < ICMP_HDR_LEN) return 0;
+            hdr = ICMP_HDR_LEN;
+            break;
+
+        default:
+            hdr = 0;
+            break;
+    }
+
+    out->payload = p + hdr;
+    out->payload_len = len - hdr;
+    return 1;
+}
+
+/* ---------------------------------------------------------------
+ *   IPv4: honour the header length and total length (Ethernet
+ *   frames may be padded past the datagram)
+ * --------------------------------------------------------------- */
+static int decodeIPv4(const uint8_t *p, uint32_t len, DecodedPacket *out) {
+    if (len < IPV4_MIN_HDR_LEN || (p[0] >> 4) != 4) return 0;
+    uint32_t ihl = (uint32_t)(p[0] & 0x0F) * 4u;
+    uint32_t total = readBE16(p + 2);
+    if (ihl < IPV4_MIN_HDR_LEN || ihl > len || total < ihl) return 0;
+    if (total < len) len = total;
+
+    out->ip_version = 4;
+    out->ip_proto = p[9];
+    memcpy(out->src_addr, p + 12, 4);
+    memcpy(out->dst_addr, p + 16, 4);
+
+    // Only the first fragment carries the transport header
+    if ((readBE16(p + 6) & 0x1FFF) != 0) return 0;
+    return decodeTransport(p + ihl, len - ihl, out);
+}
+
+/* ---------------------------------------------------------------
+ *   IPv6: walk the extension header chain to the upper layer
+ * --------------------------------------------------------------- */
+static int decodeIPv6(const uint8_t *p, uint32_t len, DecodedPacket *out) {
+    if (len < IPV6_HDR_LEN || (p[0] >> 4) != 6) return 0;
+    uint32_t total = IPV6_HDR_LEN + (uint32_t)readBE16(p + 4);
+    if (total < len) len = total;
+
+    out->ip_version = 6;
+    memcpy(out->src_addr, p + 8, 16);
+    memcpy(out->dst_addr, p + 24, 16);
+
+    uint8_t next = p[6];
+    uint32_t off = IPV6_HDR_LEN;
+    for (int i = 0; i < IPV6_MAX_EXT_HDRS; i++) {
+        uint32_t ext;
+        switch (next) {
+            case 0:   // Hop-by-Hop options
+            case 43:  // Routing
+            case 60:  // Destination options
+                if (len - off < 8) return 0;
+                ext = ((uint32_t)p[off + 1] + 1u) * 8u;
+                break;
+            case 44:  // Fragment: only the first carries the upper header
+                if (len - off < 8) return 0;
+                if ((readBE16(p + off + 2) & 0xFFF8) != 0) return 0;
+                ext = 8;
+                break;
+            case 51:  // Authentication header
+                if (len - off < 8) return 0;
+                ext = ((uint32_t)p[off + 1] + 2u) * 4u;
+                break;
+            case 59:  // No next header
+                return 0;
+            default:
+                out->ip_proto = next;
+                return decodeTransport(p + off, len - off, out);
+        }
+        if (ext > len - off) return 0;
+        next = p[off];
+        off += ext;
+    }
+    return 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Dispatch on the IP version nibble (raw IP link types)
+ * --------------------------------------------------------------- */
+static int decodeIP(const uint8_t *p, uint32_t len, DecodedPacket *out) {
+    if (len == 0) return 0;
+    switch (p[0] >> 4) {
+        case 4:  return decodeIPv4(p, len, out);
+        case 6:  return decodeIPv6(p, len, out);
+        default: return 0;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Decode an Ethernet-style EtherType and its payload
+ * --------------------------------------------------------------- */
+static int decodeEtherType(uint16_t type, const uint8_t *p, uint32_t len,
+                           DecodedPacket *out) {
+    switch (type) {
+        case ETHERTYPE_IPV4: return decodeIPv4(p, len, out);
+        case ETHERTYPE_IPV6: return decodeIPv6(p, len, out);
+        default:             return 0;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Decode one frame of the given link type. Returns 1 and fills
+ *   out when an IP packet's payload was located (it may be
+ *   empty), 0 for anything else.
+ * --------------------------------------------------------------- */
+int decodePacket(uint32_t linktype, const uint8_t *frame, uint32_t len,
+                 DecodedPacket *out) {
+    memset(out, 0, sizeof(*out));
+    if (!frame) return 0;
+
+    switch (linktype) {
+        case LINKTYPE_ETHERNET: {
+            if (len < ETH_HDR_LEN) return 0;
+            uint16_t type = readBE16(frame + 12);
+            uint32_t off = ETH_HDR_LEN;
+            while (type == ETHERTYPE_VLAN || type == ETHERTYPE_QINQ ||
+                   type == ETHERTYPE_QINQ_OLD) {
+                if (len - off < VLAN_TAG_LEN) return 0;
+                type = readBE16(frame + off + 2);
+                off += VLAN_TAG_LEN;
+            }
+            return decodeEtherType(type, frame + off, len - off, out);
+        }
+
+        case LINKTYPE_LINUX_SLL:
+            if (len < SLL_HDR_LEN) return 0;
+            return decodeEtherType(readBE16(frame + 14), frame + SLL_HDR_LEN,
+                                   len - SLL_HDR_LEN, out);
+
+        case LINKTYPE_NULL:
+            // Address family is in host order; the version nibble suffices
+            if (len < NULL_HDR_LEN) return 0;
+            return decodeIP(frame + NULL_HDR_LEN, len - NULL_HDR_LEN, out);
+
+        case LINKTYPE_RAW:
+        case LINKTYPE_IPV4:
+        case LINKTYPE_IPV6:
+            return decodeIP(frame, len, out);
+
+        default:
+            return 0;
+    }
+}
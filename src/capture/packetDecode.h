@@ -0,0 +1,49 @@
+#ifndef SRC_CAPTURE_PACKETDECODE_H_
+#define SRC_CAPTURE_PACKETDECODE_H_
+
+#include <stdint.h>
+
+/* ---------------------------------------------------------------
+ *                   IP protocol numbers used
+ * --------------------------------------------------------------- */
+#define IPPROTO_NUM_ICMP    1
+#define IPPROTO_NUM_TCP     6
+#define IPPROTO_NUM_UDP     17
+#define IPPROTO_NUM_ICMPV6  58
+
+/* ---------------------------------------------------------------
+ *                         TCP flags
+ * --------------------------------------------------------------- */
+#define TCP_FLAG_FIN  0x01
+#define TCP_FLAG_SYN  0x02
+#define TCP_FLAG_RST  0x04
+#define TCP_FLAG_ACK  0x10
+
+/* ---------------------------------------------------------------
+ * DecodedPacket:
+ *   The 5-tuple and application payload of one captured frame.
+ *   Addresses are in network byte order; IPv4 addresses use the
+ *   first 4 bytes. Ports are in host byte order and 0 for
+ *   protocols without ports. tcp_seq and tcp_flags are only set
+ *   for TCP. `payload` points into the frame.
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint8_t        ip_version;
+    uint8_t        ip_proto;
+    uint16_t       src_port;
+    uint16_t       dst_port;
+    uint8_t        src_addr[16];
+    uint8_t        dst_addr[16];
+    uint8_t        tcp_flags;
+    uint32_t       tcp_seq;
+    const uint8_t *payload;
+    uint32_t       payload_len;
+} DecodedPacket;
+
+/* ---------------------------------------------------------------
+ *                     Packet Decoding API
+ * --------------------------------------------------------------- */
+int decodePacket(uint32_t linktype, const uint8_t *frame, uint32_t len,
+                 DecodedPacket *out);
+
+#endif  // SRC_CAPTURE_PACKETDECODE_H_
@@ -0,0 +1,84 @@
+/*
+ *                  Classic Pcap Capture Reader
+ *
+ * ---------------------------------------------------------------
+ * Walks the records of a libpcap capture file that is already in
+ * memory, without copying packet data. The magic number in the
+ * global header selects the timestamp resolution and whether
+ * header fields must be byte-swapped.
+ *
+ * Reference:
+ *   "PCAP Capture File Format," IETF draft-ietf-opsawg-pcap.
+ * --------------------------------------------------------------- */
+
+#include <string.h>
+
+#include "pcapReader.h"
+
+#define PCAP_MAGIC_USEC     0xa1b2c3d4u
+#define PCAP_MAGIC_NSEC     0xa1b23c4du
+#define PCAP_GLOBAL_HDR_LEN 24
+#define PCAP_RECORD_HDR_LEN 16
+
+/* ---------------------------------------------------------------
+ *   Read a 32-bit header field in the capture's byte order
+ * --------------------------------------------------------------- */
+static uint32_t readField32(const PcapReader *r, const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return r->swapped ? __builtin_bswap32(v) : v;
+}
+
+/* ---------------------------------------------------------------
+ *   Parse the global header of the capture in data. Returns 0 on
+ *   success, -1 if data is not a classic pcap capture.
+ * --------------------------------------------------------------- */
+int openPcapReader(PcapReader *r, const uint8_t *data, size_t len) {
+    memset(r, 0, sizeof(*r));
+    if (!data || len < PCAP_GLOBAL_HDR_LEN) return -1;
+
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    if (magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC) {
+        r->swapped = 0;
+    } else if (__builtin_bswap32(magic) == PCAP_MAGIC_USEC ||
+               __builtin_bswap32(magic) == PCAP_MAGIC_NSEC) {
+        r->swapped = 1;
+        magic = __builtin_bswap32(magic);
+    } else {
+        return -1;
+    }
+
+    r->data = data;
+    r->len = len;
+    r->nanosec = (magic == PCAP_MAGIC_NSEC);
+    r->snaplen = readField32(r, data + 16);
+    // The upper bits of the link-type field carry FCS information
+    r->linktype = readField32(r, data + 20) & 0x0FFFFFFFu;
+    r->pos = PCAP_GLOBAL_HDR_LEN;
+    return 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Advance to the next record. Returns 1 with pkt filled in, 0 at
+ *   the end of the capture, or -1 if the last record is truncated.
+ * --------------------------------------------------------------- */
+int nextPcapPacket(PcapReader *r, PcapPacket *pkt) {
+    if (r->pos >= r->len) return 0;
+    if (r->len - r->pos < PCAP_RECORD_HDR_LEN) return -1;
+
+    const uint8_t *hdr = r->data + r->pos;
+    uint32_t caplen = readField32(r, hdr + 8);
+    if (caplen > r->len - r->pos - PCAP_RECORD_HDR_LEN) return -1;
+
+    pkt->ts_sec = readField32(r, hdr);
+    pkt->ts_nsec = readField32(r, hdr + 4);
+    if (!r->nanosec) pkt->ts_nsec *= 1000u;
+    pkt->caplen = caplen;
+    pkt->origlen = readField32(r, hdr + 12);
+    pkt->linktype = r->linktype;
+    pkt->data = hdr + PCAP_RECORD_HDR_LEN;
+
+    r->pos += PCAP_RECORD_HDR_LEN + caplen;
+    return 1;
+}
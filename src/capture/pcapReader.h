@@ -0,0 +1,55 @@
+#ifndef SRC_CAPTURE_PCAPREADER_H_
+#define SRC_CAPTURE_PCAPREADER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ---------------------------------------------------------------
+ *   Link-layer header types (tcpdump.org LINKTYPE_* values)
+ * --------------------------------------------------------------- */
+#define LINKTYPE_NULL       0
+#define LINKTYPE_ETHERNET   1
+#define LINKTYPE_RAW        101
+#define LINKTYPE_LINUX_SLL  113
+#define LINKTYPE_IPV4       228
+#define LINKTYPE_IPV6       229
+
+/* ---------------------------------------------------------------
+ * PcapReader:
+ *   Cursor over a classic libpcap capture held in memory. Both
+ *   microsecond and nanosecond timestamp formats are accepted, in
+ *   either byte order (`swapped` is set when the file was written
+ *   on a host of the other endianness).
+ * --------------------------------------------------------------- */
+typedef struct {
+    const uint8_t *data;
+    size_t         len;
+    size_t         pos;
+    int            swapped;
+    int            nanosec;
+    uint32_t       linktype;
+    uint32_t       snaplen;
+} PcapReader;
+
+/* ---------------------------------------------------------------
+ * PcapPacket:
+ *   One captured record. `data` points into the reader's buffer
+ *   and holds caplen bytes of the origlen bytes on the wire.
+ *   linktype is that of the interface the packet was captured on.
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint64_t       ts_sec;
+    uint32_t       ts_nsec;
+    uint32_t       caplen;
+    uint32_t       origlen;
+    uint32_t       linktype;
+    const uint8_t *data;
+} PcapPacket;
+
+/* ---------------------------------------------------------------
+ *                       Pcap Reader API
+ * --------------------------------------------------------------- */
+int openPcapReader(PcapReader *r, const uint8_t *data, size_t len);
+int nextPcapPacket(PcapReader *r, PcapPacket *pkt);
+
+#endif  // SRC_CAPTURE_PCAPREADER_H_
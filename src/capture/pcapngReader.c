@@ -0,0 +1,247 @@
+/*
+ *                      Pcapng Capture Reader
+ *
+ * ---------------------------------------------------------------
+ * Walks the blocks of a pcapng capture that is already in memory
+ * (typically mmap'ed) and yields its packets without copying
+ * them: each packet's data pointer addresses the block body in
+ * place. Understood blocks:
+ *
+ *   SHB  Section Header           byte order; starts a section
+ *   IDB  Interface Description    link type, snap length and the
+ *                                 if_tsresol / if_tsoffset options
+ *   EPB  Enhanced Packet          packet on any interface
+ *   SPB  Simple Packet            packet on interface 0, untimed
+ *
+ * Every other block type is skipped by its length. Lengths and
+ * offsets are checked against the block, never trusted.
+ *
+ * Reference:
+ *   "PCAP Now Generic (pcapng) Capture File Format,"
+ *   IETF draft-ietf-opsawg-pcapng.
+ * --------------------------------------------------------------- */
+
+#include <string.h>
+
+#include "pcapngReader.h"
+
+#define PCAPNG_BLOCK_SHB       0x0A0D0D0Au
+#define PCAPNG_BLOCK_IDB       0x00000001u
+#define PCAPNG_BLOCK_SPB       0x00000003u
+#define PCAPNG_BLOCK_EPB       0x00000006u
+#define PCAPNG_BYTE_ORDER      0x1A2B3C4Du
+
+#define PCAPNG_BLOCK_MIN_LEN   12      // type, length, trailing length
+#define PCAPNG_SHB_MIN_LEN     28
+#define PCAPNG_IDB_MIN_LEN     20
+#define PCAPNG_EPB_MIN_LEN     32
+#define PCAPNG_SPB_MIN_LEN     16
+
+#define PCAPNG_OPT_END         0
+#define PCAPNG_OPT_TSRESOL     9
+#define PCAPNG_OPT_TSOFFSET    14
+
+#define NSEC_PER_SEC           1000000000ull
+
+/* ---------------------------------------------------------------
+ *   Read header fields in the current section's byte order
+ * --------------------------------------------------------------- */
+static uint16_t readField16(const PcapngReader *r, const uint8_t *p) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return r->swapped ? __builtin_bswap16(v) : v;
+}
+
+static uint32_t readField32(const PcapngReader *r, const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return r->swapped ? __builtin_bswap32(v) : v;
+}
+
+static uint64_t readField64(const PcapngReader *r, const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return r->swapped ? __builtin_bswap64(v) : v;
+}
+
+static size_t pad4(size_t n) {
+    return (n + 3) & ~(size_t)3;
+}
+
+/* ---------------------------------------------------------------
+ *   Units per second for an if_tsresol value: 10^-v seconds, or
+ *   2^-(v & 0x7F) when the top bit is set. Saturates at 2^63.
+ * --------------------------------------------------------------- */
+static uint64_t tsUnitsPerSec(uint8_t resol) {
+    uint64_t units = 1;
+    if (resol & 0x80) {
+        int bits = resol & 0x7F;
+        return bits >= 63 ? (1ull << 63) : (1ull << bits);
+    }
+    for (int i = 0; i < resol; i++) {
+        if (units > (1ull << 63) / 10) return 1ull << 63;
+        units *= 10;
+    }
+    return units;
+}
+
+/* ---------------------------------------------------------------
+ *   Start a section at the SHB at pos: take its byte order and
+ *   forget the previous section's interfaces. Returns 0, or -1 if
+ *   the byte-order magic is not recognised.
+ * --------------------------------------------------------------- */
+static int beginSection(PcapngReader *r, const uint8_t *block) {
+    uint32_t magic;
+    memcpy(&magic, block + 8, sizeof(magic));
+    if (magic == PCAPNG_BYTE_ORDER) r->swapped = 0;
+    else if (__builtin_bswap32(magic) == PCAPNG_BYTE_ORDER) r->swapped = 1;
+    else return -1;
+    r->interface_count = 0;
+    return 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Record the interface an IDB describes, with its timestamp
+ *   options. IDBs beyond PCAPNG_MAX_INTERFACES are counted but
+ *   their packets are skipped.
+ * --------------------------------------------------------------- */
+static void addInterface(PcapngReader *r, const uint8_t *block, uint32_t block_len) {
+    uint32_t id = r->interface_count++;
+    if (id >= PCAPNG_MAX_INTERFACES) return;
+
+    PcapngInterface *ifc = &r->interfaces[id];
+    ifc->linktype = readField16(r, block + 8);
+    ifc->snaplen = readField32(r, block + 12);
+    ifc->ts_units_per_sec = 1000000;
+    ifc->ts_offset_sec = 0;
+
+    // Options run from offset 16 up to the trailing length field
+    size_t pos = 16;
+    size_t end = block_len - 4;
+    while (end - pos >= 4) {
+        uint16_t code = readField16(r, block + pos);
+        uint16_t len = readField16(r, block + pos + 2);
+        pos += 4;
+        if (code == PCAPNG_OPT_END || len > end - pos) break;
+        if (code == PCAPNG_OPT_TSRESOL && len >= 1)
+            ifc->ts_units_per_sec = tsUnitsPerSec(block[pos]);
+        else if (code == PCAPNG_OPT_TSOFFSET && len >= 8)
+            ifc->ts_offset_sec = (int64_t)readField64(r, block + pos);
+        pos += pad4(len);
+        if (pos > end) break;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Convert a raw timestamp on interface ifc to seconds and
+ *   nanoseconds
+ * --------------------------------------------------------------- */
+static void convertTimestamp(const PcapngInterface *ifc, uint64_t ts, PcapPacket *pkt) {
+    uint64_t units = ifc->ts_units_per_sec;
+    uint64_t frac = ts % units;
+    pkt->ts_sec = ts / units + (uint64_t)ifc->ts_offset_sec;
+    pkt->ts_nsec = (uint32_t)((unsigned __int128)frac * NSEC_PER_SEC / units);
+}
+
+/* ---------------------------------------------------------------
+ *   Check for a leading SHB and take its byte order. Returns 0 on
+ *   success, -1 if data is not a pcapng capture.
+ * --------------------------------------------------------------- */
+int openPcapngReader(PcapngReader *r, const uint8_t *data, size_t len) {
+    memset(r, 0, sizeof(*r));
+    if (!data || len < PCAPNG_SHB_MIN_LEN) return -1;
+
+    uint32_t type;
+    memcpy(&type, data, sizeof(type));
+    if (type != PCAPNG_BLOCK_SHB) return -1;  // palindromic: order-independent
+    if (beginSection(r, data) != 0) return -1;
+
+    r->data = data;
+    r->len = len;
+    r->pos = 0;
+    return 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Advance to the next packet, handling section and interface
+ *   blocks on the way. Returns 1 with pkt filled in, 0 at the end
+ *   of the capture, or -1 if a block is truncated or malformed.
+ * --------------------------------------------------------------- */
+int nextPcapngPacket(PcapngReader *r, PcapPacket *pkt) {
+    while (r->pos < r->len) {
+        if (r->len - r->pos < PCAPNG_BLOCK_MIN_LEN) return -1;
+        const uint8_t *block = r->data + r->pos;
+
+        uint32_t type;
+        memcpy(&type, block, sizeof(type));
+        if (type == PCAPNG_BLOCK_SHB) {
+            if (r->len - r->pos < PCAPNG_SHB_MIN_LEN || beginSection(r, block) != 0)
+                return -1;
+        } else {
+            type = readField32(r, block);
+        }
+
+        uint32_t block_len = readField32(r, block + 4);
+        if (block_len < PCAPNG_BLOCK_MIN_LEN || (block_len & 3) ||
+            block_len > r->len - r->pos)
+            return -1;
+        r->pos += block_len;
+
+        switch (type) {
+            case PCAPNG_BLOCK_SHB:
+                break;
+
+            case PCAPNG_BLOCK_IDB:
+                if (block_len < PCAPNG_IDB_MIN_LEN) return -1;
+                addInterface(r, block, block_len);
+                break;
+
+            case PCAPNG_BLOCK_EPB: {
+                if (block_len < PCAPNG_EPB_MIN_LEN) return -1;
+                uint32_t id = readField32(r, block + 8);
+                uint32_t caplen = readField32(r, block + 20);
+                if (caplen > block_len - PCAPNG_EPB_MIN_LEN) return -1;
+                if (id >= r->interface_count || id >= PCAPNG_MAX_INTERFACES) {
+                    r->skipped_blocks++;
+                    break;
+                }
+                const PcapngInterface *ifc = &r->interfaces[id];
+                uint64_t ts = ((uint64_t)readField32(r, block + 12) << 32) |
+                              readField32(r, block + 16);
+                convertTimestamp(ifc, ts, pkt);
+                r->last_ts_sec = pkt->ts_sec;
+                r->last_ts_nsec = pkt->ts_nsec;
+                pkt->caplen = caplen;
+                pkt->origlen = readField32(r, block + 24);
+                pkt->linktype = ifc->linktype;
+                pkt->data = block + 28;
+                return 1;
+            }
+
+            case PCAPNG_BLOCK_SPB: {
+                if (block_len < PCAPNG_SPB_MIN_LEN) return -1;
+                if (r->interface_count == 0) {
+                    r->skipped_blocks++;
+                    break;
+                }
+                const PcapngInterface *ifc = &r->interfaces[0];
+                uint32_t origlen = readField32(r, block + 8);
+                uint32_t caplen = block_len - PCAPNG_SPB_MIN_LEN;
+                if (origlen < caplen) caplen = origlen;
+                if (ifc->snaplen && ifc->snaplen < caplen) caplen = ifc->snaplen;
+                pkt->ts_sec = r->last_ts_sec;
+                pkt->ts_nsec = r->last_ts_nsec;
+                pkt->caplen = caplen;
+                pkt->origlen = origlen;
+                pkt->linktype = ifc->linktype;
+                pkt->data = block + 12;
+                return 1;
+            }
+
+            default:
+                r->skipped_blocks++;
+                break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef SRC_CAPTURE_PCAPNGREADER_H_
+#define SRC_CAPTURE_PCAPNGREADER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "pcapReader.h"
+
+#define PCAPNG_MAX_INTERFACES  256
+
+/* ---------------------------------------------------------------
+ * PcapngInterface:
+ *   What an Interface Description Block declares: the link type,
+ *   snap length and timestamp unit of the packets captured on it.
+ *   Timestamps count units of 1 / ts_units_per_sec seconds and are
+ *   shifted by ts_offset_sec.
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint32_t linktype;
+    uint32_t snaplen;
+    uint64_t ts_units_per_sec;
+    int64_t  ts_offset_sec;
+} PcapngInterface;
+
+/* ---------------------------------------------------------------
+ * PcapngReader:
+ *   Cursor over a pcapng capture held in memory. Each Section
+ *   Header Block sets the byte order of its section and clears the
+ *   interface list; interfaces are numbered in the order of their
+ *   IDBs within the section. Packet data is never copied.
+ * --------------------------------------------------------------- */
+typedef struct {
+    const uint8_t  *data;
+    size_t          len;
+    size_t          pos;
+    int             swapped;
+    uint32_t        interface_count;
+    PcapngInterface interfaces[PCAPNG_MAX_INTERFACES];
+    uint64_t        last_ts_sec;       // for Simple Packet Blocks, which
+    uint32_t        last_ts_nsec;      // carry no timestamp
+    uint64_t        skipped_blocks;
+} PcapngReader;
+
+/* ---------------------------------------------------------------
+ *                      Pcapng Reader API
+ * --------------------------------------------------------------- */
+int openPcapngReader(PcapngReader *r, const uint8_t *data, size_t len);
+int nextPcapngPacket(PcapngReader *r, PcapPacket *pkt);
+
+#endif  // SRC_CAPTURE_PCAPNGREADER_H_
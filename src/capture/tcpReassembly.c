@@ -0,0 +1,157 @@
+/*
+ *                     TCP Stream Reassembly
+ *
+ * ---------------------------------------------------------------
+ * Turns the segments of each TCP flow direction into an ordered
+ * byte stream. In-order bytes are handed to the consumer as soon
+ * as they arrive, straight from the packet, so nothing is copied
+ * on the common path and no reassembled buffer is kept. Only
+ * segments that arrive ahead of a gap are copied, and at most
+ * TCP_REASM_MAX_OOO bytes of them per direction; when that bound
+ * would be exceeded the oldest gap is skipped and the stream
+ * resumes at the first buffered segment. Retransmitted bytes are
+ * trimmed so each stream byte is delivered once (first copy wins).
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tcpReassembly.h"
+
+#define SEQ_LT(a, b)   ((int32_t)((uint32_t)(a) - (uint32_t)(b)) < 0)
+#define SEQ_LEQ(a, b)  ((int32_t)((uint32_t)(a) - (uint32_t)(b)) <= 0)
+
+/* ---------------------------------------------------------------
+ *   Hand len in-order bytes on and advance the direction
+ * --------------------------------------------------------------- */
+static void deliverBytes(Flow *f, int dir, const uint8_t *data, uint32_t len, int gap,
+                         TcpReassemblyStats *st, StreamDeliverFn deliver, void *ctx) {
+    FlowHalf *h = &f->half[dir];
+    deliver(f, dir, data, len, h->delivered, gap, ctx);
+    h->delivered += len;
+    h->next_seq += len;
+    st->bytes_delivered += len;
+}
+
+/* ---------------------------------------------------------------
+ *   Deliver buffered segments that the stream has now reached
+ * --------------------------------------------------------------- */
+static void drainSegments(Flow *f, int dir, int gap, TcpReassemblyStats *st,
+                          StreamDeliverFn deliver, void *ctx) {
+    FlowHalf *h = &f->half[dir];
+    TcpSegment *seg;
+    while ((seg = h->ooo) && SEQ_LEQ(seg->seq, h->next_seq)) {
+        h->ooo = seg->next;
+        h->ooo_bytes -= seg->len;
+        uint32_t skip = h->next_seq - seg->seq;
+        if (skip < seg->len) {
+            st->overlap_bytes += skip;
+            deliverBytes(f, dir, seg->data + skip, seg->len - skip, gap, st, deliver, ctx);
+            gap = 0;
+        } else {
+            st->overlap_bytes += seg->len;
+        }
+        free(seg);
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Give up on the gap before the first buffered segment
+ * --------------------------------------------------------------- */
+static void skipGap(Flow *f, int dir, TcpReassemblyStats *st,
+                    StreamDeliverFn deliver, void *ctx) {
+    FlowHalf *h = &f->half[dir];
+    st->gaps_skipped++;
+    h->next_seq = h->ooo->seq;
+    drainSegments(f, dir, 1, st, deliver, ctx);
+}
+
+/* ---------------------------------------------------------------
+ *   Queue a copy of a segment that starts past next_seq, keeping
+ *   the list sorted by sequence number
+ * --------------------------------------------------------------- */
+static void bufferSegment(FlowHalf *h, uint32_t seq, const uint8_t *data, uint32_t len) {
+    TcpSegment **pp = &h->ooo;
+    while (*pp && SEQ_LEQ((*pp)->seq, seq)) {
+        // Already buffered in full: nothing to add
+        if ((*pp)->seq == seq && (*pp)->len >= len) return;
+        pp = &(*pp)->next;
+    }
+
+    TcpSegment *seg = malloc(sizeof(TcpSegment) + len);
+    if (!seg) {
+        fprintf(stderr, "Memory allocation failed for TcpSegment.\n");
+        exit(EXIT_FAILURE);
+    }
+    seg->seq = seq;
+    seg->len = len;
+    memcpy(seg->data, data, len);
+    seg->next = *pp;
+    *pp = seg;
+    h->ooo_bytes += len;
+}
+
+/* ---------------------------------------------------------------
+ *   Track dp, a TCP packet of flow f sent in direction dir, and
+ *   deliver whatever stream bytes it makes available in order.
+ *   A SYN fixes the initial sequence number; a flow picked up
+ *   mid-stream starts at its first data segment.
+ * --------------------------------------------------------------- */
+void reassembleTcp(Flow *f, int dir, const DecodedPacket *dp, TcpReassemblyStats *st,
+                   StreamDeliverFn deliver, void *ctx) {
+    FlowHalf *h = &f->half[dir];
+    uint32_t seq = dp->tcp_seq;
+    const uint8_t *data = dp->payload;
+    uint32_t len = dp->payload_len;
+
+    if (dp->tcp_flags & TCP_FLAG_SYN) {
+        seq++;
+        if (!h->seq_valid) {
+            h->next_seq = seq;
+            h->seq_valid = 1;
+        }
+    }
+    if (dp->tcp_flags & TCP_FLAG_FIN) h->fin = 1;
+    if (len == 0) return;
+    st->segments++;
+
+    if (!h->seq_valid) {
+        h->next_seq = seq;
+        h->seq_valid = 1;
+    }
+
+    for (;;) {
+        if (SEQ_LT(seq, h->next_seq)) {
+            uint32_t old = h->next_seq - seq;
+            if (old >= len) {
+                st->retransmitted++;
+                return;
+            }
+            st->overlap_bytes += old;
+            data += old;
+            len -= old;
+            seq = h->next_seq;
+        }
+
+        if (seq == h->next_seq) {
+            st->in_order++;
+            deliverBytes(f, dir, data, len, 0, st, deliver, ctx);
+            drainSegments(f, dir, 0, st, deliver, ctx);
+            return;
+        }
+
+        if (seq - h->next_seq > TCP_REASM_WINDOW) {
+            st->dropped++;
+            return;
+        }
+        if (h->ooo_bytes + len <= TCP_REASM_MAX_OOO || !h->ooo) break;
+
+        // Over the buffering bound: resume at the first buffered
+        // segment, then place this one against the new next_seq
+        skipGap(f, dir, st, deliver, ctx);
+    }
+
+    st->out_of_order++;
+    bufferSegment(h, seq, data, len);
+}
@@ -0,0 +1,41 @@
+#ifndef SRC_CAPTURE_TCPREASSEMBLY_H_
+#define SRC_CAPTURE_TCPREASSEMBLY_H_
+
+#include <stdint.h>
+
+#include "flowTable.h"
+#include "packetDecode.h"
+
+#define TCP_REASM_WINDOW   (1u << 20)      // furthest accepted byte past next_seq
+#define TCP_REASM_MAX_OOO  (64u * 1024)    // buffered out-of-order bytes per direction
+
+/* ---------------------------------------------------------------
+ *   Receives the in-order bytes of one flow direction. `offset`
+ *   is the stream offset of data[0]; `gap` is set when bytes
+ *   before it were skipped (lost or never captured), so the
+ *   stream is not contiguous with the previous delivery.
+ * --------------------------------------------------------------- */
+typedef void (*StreamDeliverFn)(Flow *f, int dir, const uint8_t *data, uint32_t len,
+                                uint64_t offset, int gap, void *ctx);
+
+/* ---------------------------------------------------------------
+ *                  Reassembly counters
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint64_t segments;         // TCP segments with payload
+    uint64_t in_order;         // delivered on arrival
+    uint64_t out_of_order;     // buffered until the gap before them filled
+    uint64_t retransmitted;    // wholly before next_seq, dropped
+    uint64_t overlap_bytes;    // already-delivered bytes trimmed off
+    uint64_t dropped;          // beyond the window, dropped
+    uint64_t gaps_skipped;     // holes given up on to bound buffering
+    uint64_t bytes_delivered;
+} TcpReassemblyStats;
+
+/* ---------------------------------------------------------------
+ *                    TCP Reassembly API
+ * --------------------------------------------------------------- */
+void reassembleTcp(Flow *f, int dir, const DecodedPacket *dp, TcpReassemblyStats *st,
+                   StreamDeliverFn deliver, void *ctx);
+
+#endif  // SRC_CAPTURE_TCPREASSEMBLY_H_
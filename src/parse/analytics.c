@@ -9,12 +9,15 @@ MemoryStats *global_mem_stats = NULL;
 
 /* ---------------------------------------------------------------
  *                      Memory tracking wrappers
+ *
+ *   Counters are bumped atomically since engines may be built on
+ *   a background reload thread while another thread scans.
  * --------------------------------------------------------------- */
 void *track_malloc(size_t size) {
     void *ptr = malloc(size);
     if (ptr && global_mem_stats) {
-        global_mem_stats->alloc_count++;
-        global_mem_stats->total_bytes += size;
+        __atomic_fetch_add(&global_mem_stats->alloc_count, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&global_mem_stats->total_bytes, size, __ATOMIC_RELAXED);
     }
     return ptr;
 }
@@ -22,8 +25,8 @@ void *track_malloc(size_t size) {
 void *track_calloc(size_t count, size_t size) {
     void *ptr = calloc(count, size);
     if (ptr && global_mem_stats) {
-        global_mem_stats->alloc_count++;
-        global_mem_stats->total_bytes += count * size;
+        __atomic_fetch_add(&global_mem_stats->alloc_count, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&global_mem_stats->total_bytes, count * size, __ATOMIC_RELAXED);
     }
     return ptr;
 }
@@ -31,8 +34,8 @@ void *track_calloc(size_t count, size_t size) {
 void *track_realloc(void *ptr, size_t size) {
     void *new_ptr = realloc(ptr, size);
     if (new_ptr && global_mem_stats) {
-        global_mem_stats->alloc_count++;
-        global_mem_stats->total_bytes += size;
+        __atomic_fetch_add(&global_mem_stats->alloc_count, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&global_mem_stats->total_bytes, size, __ATOMIC_RELAXED);
     }
     return new_ptr;
 }
@@ -40,6 +43,6 @@ void *track_realloc(void *ptr, size_t size) {
 void track_free(void *ptr) {
     if (!ptr) return;
     if (global_mem_stats)
-        global_mem_stats->free_count++;
+        __atomic_fetch_add(&global_mem_stats->free_count, 1, __ATOMIC_RELAXED);
     free(ptr);
 }
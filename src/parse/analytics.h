@@ -62,6 +62,30 @@ static inline void compute_throughput(AlgorithmStats *s) {
     }
 }
 
+/* ---------------------------------------------------------------
+ *         Add the counters and timing of s into a total
+ * --------------------------------------------------------------- */
+static inline void accumulate_algorithm_stats(AlgorithmStats *total,
+                                              const AlgorithmStats *s) {
+    if (!total || !s) return;
+    total->chars_scanned     += s->chars_scanned;
+    total->comparisons       += s->comparisons;
+    total->transitions       += s->transitions;
+    total->fail_steps        += s->fail_steps;
+    total->shifts            += s->shifts;
+    total->matches           += s->matches;
+    total->windows           += s->windows;
+    total->sum_shift         += s->sum_shift;
+    total->hash_hits         += s->hash_hits;
+    total->bloom_checks      += s->bloom_checks;
+    total->bloom_pass        += s->bloom_pass;
+    total->chain_steps       += s->chain_steps;
+    total->exact_matches     += s->exact_matches;
+    total->verif_after_bloom += s->verif_after_bloom;
+    total->elapsed_sec       += s->elapsed_sec;
+    total->file_size         += s->file_size;
+}
+
 /* ---------------------------------------------------------------
  *                 Print runtime algorithm stats
  * --------------------------------------------------------------- */
@@ -0,0 +1,406 @@
+/*
+ *                    Rule Option Evaluation
+ *
+ * ---------------------------------------------------------------
+ * Confirms a rule once the multi-pattern prefilter has found its
+ * fast pattern. The remaining contents are checked in rule order
+ * against their positional constraints:
+ *
+ *   offset / depth      - absolute window from the buffer start
+ *   distance / within   - window relative to the end of the
+ *                         previous content match (the cursor)
+ *   content:!"..."      - must not occur in its window
+ *
+ * The fast pattern itself is pinned to the position reported by
+ * the engine. Earlier contents are backtracked over (bounded by
+ * EVAL_BACKTRACK_LIMIT) so that a later relative content can be
+ * satisfied by a different occurrence, as Snort does.
+ *
+ * Reference:
+ *   Snort payload options:
+ *     https://docs.snort.org/rules/options/payload/
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "evalRules.h"
+
+#define EVAL_BACKTRACK_LIMIT 4096
+
+/* ---------------------------------------------------------------
+ *   Read-only state shared by one rule evaluation
+ * --------------------------------------------------------------- */
+typedef struct {
+    const SnortRule     *rule;
+    const RuleContent   *contents;
+    const unsigned char *pool;
+    const unsigned char *data;
+    size_t               len;
+    size_t               anchor_start;
+    int                  budget;
+} EvalState;
+
+/* ---------------------------------------------------------------
+ *   Compute the [lo, hi) window a content must fall in, given the
+ *   current cursor. Returns 0 if the window is empty.
+ * --------------------------------------------------------------- */
+static int contentWindow(const RuleContent *c, size_t cursor, size_t len,
+                         size_t *lo, size_t *hi) {
+    int64_t start, stop;
+    if (c->mods.relative) {
+        start = (int64_t)cursor + c->mods.distance;
+        stop = c->mods.within ? start + c->mods.within : (int64_t)len;
+    } else {
+        start = c->mods.offset;
+        stop = c->mods.depth ? start + c->mods.depth : (int64_t)len;
+    }
+
+    if (start < 0) start = 0;
+    if (stop > (int64_t)len) stop = (int64_t)len;
+    if (stop - start < c->length) return 0;
+
+    *lo = (size_t)start;
+    *hi = (size_t)stop;
+    return 1;
+}
+
+/* ---------------------------------------------------------------
+ *   Compare n bytes, folding ASCII case when nocase is set
+ * --------------------------------------------------------------- */
+static int bytesEqual(const unsigned char *a, const unsigned char *b,
+                      size_t n, int nocase) {
+    if (!nocase) return memcmp(a, b, n) == 0;
+    for (size_t i = 0; i < n; i++) {
+        if (tolower(a[i]) != tolower(b[i])) return 0;
+    }
+    return 1;
+}
+
+/* ---------------------------------------------------------------
+ *   Find the first occurrence of content c starting in [from, hi)
+ *   and ending by hi. Returns its start, or -1 if none.
+ * --------------------------------------------------------------- */
+static int64_t findContent(const EvalState *st, const RuleContent *c,
+                           size_t from, size_t hi) {
+    const unsigned char *pat = st->pool + c->offset;
+    size_t L = (size_t)c->length;
+    if (hi < L || from > hi - L) return -1;
+    size_t last = hi - L;
+
+    if (!c->mods.nocase) {
+        // Skip straight to candidate first bytes
+        const unsigned char *base = st->data;
+        size_t pos = from;
+        while (pos <= last) {
+            const unsigned char *hit = memchr(base + pos, pat[0], last - pos + 1);
+            if (!hit) return -1;
+            pos = (size_t)(hit - base);
+            if (memcmp(hit, pat, L) == 0) return (int64_t)pos;
+            pos++;
+        }
+        return -1;
+    }
+
+    for (size_t pos = from; pos <= last; pos++) {
+        if (bytesEqual(st->data + pos, pat, L, 1))
+            return (int64_t)pos;
+    }
+    return -1;
+}
+
+/* ---------------------------------------------------------------
+ *   Try to satisfy contents[idx..] with the cursor at `cursor`
+ * --------------------------------------------------------------- */
+static int matchFrom(EvalState *st, int idx, size_t cursor) {
+    const SnortRule *rule = st->rule;
+    const RuleContent *contents = st->contents;
+    if (idx == rule->content_count) return 1;
+
+    const RuleContent *c = &contents[idx];
+    size_t lo, hi;
+    int has_window = contentWindow(c, cursor, st->len, &lo, &hi);
+
+    if (c->mods.negated) {
+        if (has_window && findContent(st, c, lo, hi) >= 0) return 0;
+        return matchFrom(st, idx + 1, cursor);
+    }
+    if (!has_window) return 0;
+
+    if (idx == rule->fast_pattern) {
+        size_t s = st->anchor_start;
+        if (s < lo || s + (size_t)c->length > hi) return 0;
+        return matchFrom(st, idx + 1, s + (size_t)c->length);
+    }
+
+    for (int64_t pos = findContent(st, c, lo, hi); pos >= 0;
+         pos = findContent(st, c, (size_t)pos + 1, hi)) {
+        if (--st->budget < 0) return 0;
+        if (matchFrom(st, idx + 1, (size_t)pos + (size_t)c->length)) return 1;
+    }
+    return 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Check the contents whose outcome does not depend on where the
+ *   fast pattern was found: absolute positive contents must occur
+ *   in their window and absolute negated contents must not. A
+ *   failure here rules the rule out for the whole buffer.
+ * --------------------------------------------------------------- */
+static int checkAnchorIndependent(const RuleSet *rs, int rule_id,
+                                  const unsigned char *data, size_t len) {
+    const SnortRule *rule = &rs->rules[rule_id];
+    const RuleContent *contents = ruleContents(rs, rule);
+    EvalState st = {
+        .rule = rule,
+        .contents = contents,
+        .pool = rs->ps->pool,
+        .data = data,
+        .len = len,
+    };
+
+    for (int i = 0; i < rule->content_count; i++) {
+        const RuleContent *c = &contents[i];
+        if (c->mods.relative || i == rule->fast_pattern) continue;
+
+        size_t lo, hi;
+        int found = contentWindow(c, 0, len, &lo, &hi) &&
+                    findContent(&st, c, lo, hi) >= 0;
+        if (found == c->mods.negated) return 0;
+    }
+    return 1;
+}
+
+/* ---------------------------------------------------------------
+ *   Evaluate rule rule_id against a buffer whose fast pattern was
+ *   found starting at anchor_start. Cheap window checks on the
+ *   anchor and on absolute contents run first, so most failing
+ *   rules are rejected before any byte is searched.
+ *   Returns 1 if every content constraint holds.
+ * --------------------------------------------------------------- */
+int evaluateRule(const RuleSet *rs, int rule_id,
+                 const unsigned char *data, size_t len, size_t anchor_start) {
+    const SnortRule *rule = &rs->rules[rule_id];
+    const RuleContent *contents = ruleContents(rs, rule);
+    size_t lo, hi;
+
+    // O(1) rejections: anchor outside its absolute window, or an
+    // absolute positive content whose window cannot fit it
+    for (int i = 0; i < rule->content_count; i++) {
+        const RuleContent *c = &contents[i];
+        if (c->mods.relative || c->mods.negated) continue;
+        if (!contentWindow(c, 0, len, &lo, &hi)) return 0;
+        if (i == rule->fast_pattern &&
+            (anchor_start < lo || anchor_start + (size_t)c->length > hi))
+            return 0;
+    }
+
+    // A lone absolute content was settled above; a relative one is
+    // measured from the buffer start, which matchFrom does
+    if (rule->content_count == 1 && !contents[0].mods.relative) return 1;
+
+    EvalState st = {
+        .rule = rule,
+        .contents = contents,
+        .pool = rs->ps->pool,
+        .data = data,
+        .len = len,
+        .anchor_start = anchor_start,
+        .budget = EVAL_BACKTRACK_LIMIT,
+    };
+    return matchFrom(&st, 0, 0);
+}
+
+/* ---------------------------------------------------------------
+ *   Prepare a context for scanning buffers against rule set rs
+ * --------------------------------------------------------------- */
+void initRuleMatchContext(RuleMatchContext *ctx, const RuleSet *rs) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->rs = rs;
+    ctx->ps = rs->ps;
+    size_t n = rs->rule_count > 0 ? (size_t)rs->rule_count : 1;
+    ctx->verdict = calloc(n, sizeof(uint8_t));
+    ctx->checked = calloc(n, sizeof(uint8_t));
+    ctx->touched_list = malloc(n * sizeof(int));
+    if (!ctx->verdict || !ctx->checked || !ctx->touched_list) {
+        fprintf(stderr, "Memory allocation failed for RuleMatchContext.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Start a new buffer: only rules touched in the previous one are
+ *   cleared, so the reset cost is independent of rule count
+ * --------------------------------------------------------------- */
+void beginRuleBuffer(RuleMatchContext *ctx, const unsigned char *data, size_t len) {
+    for (int i = 0; i < ctx->touched_count; i++) {
+        ctx->verdict[ctx->touched_list[i]] = RULE_PENDING;
+        ctx->checked[ctx->touched_list[i]] = 0;
+    }
+    ctx->touched_count = 0;
+    ctx->data = data;
+    ctx->len = len;
+    ctx->base = 0;
+    ctx->prefix = NULL;
+    ctx->prefix_len = 0;
+    ctx->stitch_len = 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Start a buffer that is the stream bytes [base, base + len) of
+ *   a reassembled flow, preceded in the stream by `prefix`
+ * --------------------------------------------------------------- */
+void beginRuleSegment(RuleMatchContext *ctx, const unsigned char *data, size_t len,
+                      uint64_t base, const unsigned char *prefix, size_t prefix_len) {
+    beginRuleBuffer(ctx, data, len);
+    ctx->base = base;
+    ctx->prefix = prefix;
+    ctx->prefix_len = prefix_len;
+}
+
+/* ---------------------------------------------------------------
+ *   Evaluate one rule for a fast-pattern hit starting at `start`.
+ *   The anchor bytes are compared first: a streaming engine that
+ *   matched across a chunk boundary has only checked the bytes of
+ *   the current chunk against the pattern.
+ * --------------------------------------------------------------- */
+static void evaluateHit(RuleMatchContext *m, int rule_id, size_t start) {
+    if (m->verdict[rule_id] != RULE_PENDING) return;
+    m->rules_evaluated++;
+
+    const SnortRule *rule = &m->rs->rules[rule_id];
+    const RuleContent *fp = &ruleContents(m->rs, rule)[rule->fast_pattern];
+    if (!bytesEqual(m->data + start, m->rs->ps->pool + fp->offset,
+                    (size_t)fp->length, fp->mods.nocase))
+        return;
+
+    // First hit in this buffer: settle anchor-independent contents once
+    if (!m->checked[rule_id]) {
+        m->checked[rule_id] = 1;
+        m->touched_list[m->touched_count++] = rule_id;
+        if (!checkAnchorIndependent(m->rs, rule_id, m->data, m->len)) {
+            m->verdict[rule_id] = RULE_REJECTED;
+            return;
+        }
+    }
+
+    if (evaluateRule(m->rs, rule_id, m->data, m->len, start)) {
+        m->verdict[rule_id] = RULE_ALERTED;
+        m->alerts++;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Join the stream prefix and the current segment, once per
+ *   segment
+ * --------------------------------------------------------------- */
+static void buildStitch(RuleMatchContext *m) {
+    if (m->stitch_len) return;
+    size_t n = m->prefix_len + m->len;
+    if (n > m->stitch_cap) {
+        m->stitch = realloc(m->stitch, n);
+        if (!m->stitch) {
+            fprintf(stderr, "Memory allocation failed for RuleMatchContext.\n");
+            exit(EXIT_FAILURE);
+        }
+        m->stitch_cap = n;
+    }
+    memcpy(m->stitch, m->prefix, m->prefix_len);
+    memcpy(m->stitch + m->prefix_len, m->data, m->len);
+    m->stitch_len = n;
+}
+
+/* ---------------------------------------------------------------
+ *   Evaluate one rule for a fast pattern starting at `start` of
+ *   the joined prefix + segment. The anchor bytes are compared
+ *   first, since an engine scanning the segment alone may not
+ *   have seen all of them. Only an alert is recorded: a failure
+ *   here does not rule out a hit inside the segment.
+ * --------------------------------------------------------------- */
+static void evaluateStraddle(RuleMatchContext *m, int rule_id, size_t start) {
+    if (m->verdict[rule_id] != RULE_PENDING) return;
+    m->rules_evaluated++;
+
+    const SnortRule *rule = &m->rs->rules[rule_id];
+    const RuleContent *fp = &ruleContents(m->rs, rule)[rule->fast_pattern];
+    if (!bytesEqual(m->stitch + start, m->rs->ps->pool + fp->offset,
+                    (size_t)fp->length, fp->mods.nocase) ||
+        !checkAnchorIndependent(m->rs, rule_id, m->stitch, m->stitch_len) ||
+        !evaluateRule(m->rs, rule_id, m->stitch, m->stitch_len, start))
+        return;
+
+    if (!m->checked[rule_id]) {
+        m->checked[rule_id] = 1;
+        m->touched_list[m->touched_count++] = rule_id;
+    }
+    m->verdict[rule_id] = RULE_ALERTED;
+    m->alerts++;
+}
+
+/* ---------------------------------------------------------------
+ *   MatchCallback: evaluate every rule sharing pattern_id for a
+ *   hit ending at `end` in the current buffer
+ * --------------------------------------------------------------- */
+void onPrefilterHit(int pattern_id, uint64_t end, void *ctx) {
+    RuleMatchContext *m = ctx;
+    const PatternSet *ps = m->ps;
+    m->prefilter_hits++;
+
+    uint64_t plen = (uint64_t)ps->pattern_lens[pattern_id];
+    if (end >= m->base + plen) {
+        size_t start = (size_t)(end - m->base - plen);
+        for (uint32_t i = ps->rule_start[pattern_id]; i < ps->rule_start[pattern_id + 1]; i++)
+            evaluateHit(m, ps->rule_ids[i], start);
+        return;
+    }
+
+    // Fast pattern began in an earlier segment of the stream
+    uint64_t before = m->base + plen - end;
+    if (end <= m->base || before > m->prefix_len) return;
+    m->straddle_hits++;
+    buildStitch(m);
+    size_t start = m->prefix_len - (size_t)before;
+    for (uint32_t i = ps->rule_start[pattern_id]; i < ps->rule_start[pattern_id + 1]; i++)
+        evaluateStraddle(m, ps->rule_ids[i], start);
+}
+
+/* ---------------------------------------------------------------
+ *                 Print rule evaluation stats
+ * --------------------------------------------------------------- */
+void printRuleMatchStats(const RuleMatchContext *ctx) {
+    printf("\n[Rule Evaluation]\n");
+    printf("  Prefilter hits         : %lu\n", (unsigned long)ctx->prefilter_hits);
+    printf("  Rules evaluated        : %lu\n", (unsigned long)ctx->rules_evaluated);
+    printf("  Rule alerts            : %lu\n", (unsigned long)ctx->alerts);
+    if (ctx->straddle_hits)
+        printf("  Cross-segment hits     : %lu\n", (unsigned long)ctx->straddle_hits);
+}
+
+/* ---------------------------------------------------------------
+ *   Add the counters of ctx, including its engine stats, into
+ *   total. total is only read by printRuleMatchStats and may be a
+ *   zeroed context that was never initialised.
+ * --------------------------------------------------------------- */
+void addRuleMatchStats(RuleMatchContext *total, const RuleMatchContext *ctx) {
+    total->prefilter_hits  += ctx->prefilter_hits;
+    total->rules_evaluated += ctx->rules_evaluated;
+    total->alerts          += ctx->alerts;
+    total->straddle_hits   += ctx->straddle_hits;
+    accumulate_algorithm_stats(&total->engine_stats, &ctx->engine_stats);
+}
+
+/* ---------------------------------------------------------------
+ *          Release buffers owned by a RuleMatchContext
+ * --------------------------------------------------------------- */
+void freeRuleMatchContext(RuleMatchContext *ctx) {
+    free(ctx->verdict);
+    free(ctx->checked);
+    free(ctx->touched_list);
+    free(ctx->stitch);
+    ctx->stitch = NULL;
+    ctx->verdict = NULL;
+    ctx->checked = NULL;
+    ctx->touched_list = NULL;
+}
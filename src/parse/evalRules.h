@@ -0,0 +1,75 @@
+#ifndef SRC_PARSE_EVALRULES_H_
+#define SRC_PARSE_EVALRULES_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "parseRules.h"
+#include "analytics.h"
+
+/* ---------------------------------------------------------------
+ *   Per-buffer verdict of a rule
+ * --------------------------------------------------------------- */
+#define RULE_PENDING   0
+#define RULE_ALERTED   1
+#define RULE_REJECTED  2
+
+/* ---------------------------------------------------------------
+ * RuleMatchContext:
+ *   State threaded through an engine's MatchCallback while one
+ *   buffer is scanned. Each prefilter hit triggers evaluation of
+ *   the owning rule; a rule alerts at most once per buffer and is
+ *   not re-evaluated once alerted or rejected. `ps` is the
+ *   PatternSet whose ids the engine being run reports; it is the
+ *   rule set's own set unless a rule group's matcher is scanning.
+ *   engine_stats accumulates the engine counters of every scan
+ *   made with this context.
+ *
+ *   When the buffer is one segment of a reassembled stream
+ *   (beginRuleSegment), engines report ends as stream offsets and
+ *   `base` is the stream offset of data[0]. A fast pattern that
+ *   began in an earlier segment is evaluated against `prefix` (the
+ *   last bytes of the stream before this segment) joined to the
+ *   segment; the joined copy is only made when such a hit occurs.
+ * --------------------------------------------------------------- */
+typedef struct {
+    const RuleSet       *rs;
+    const PatternSet    *ps;
+    const unsigned char *data;
+    size_t               len;
+    uint8_t             *verdict;       // per rule: RULE_* for this buffer
+    uint8_t             *checked;       // anchor-independent checks done
+    int                 *touched_list;  // rules to reset on next buffer
+    int                  touched_count;
+
+    uint64_t             base;
+    const unsigned char *prefix;
+    size_t               prefix_len;
+    unsigned char       *stitch;        // prefix + data, built on demand
+    size_t               stitch_len;
+    size_t               stitch_cap;
+
+    uint64_t prefilter_hits;
+    uint64_t rules_evaluated;
+    uint64_t alerts;
+    uint64_t straddle_hits;
+
+    AlgorithmStats engine_stats;
+} RuleMatchContext;
+
+/* ---------------------------------------------------------------
+ *                     Rule Evaluation API
+ * --------------------------------------------------------------- */
+int  evaluateRule(const RuleSet *rs, int rule_id,
+                  const unsigned char *data, size_t len, size_t anchor_start);
+
+void initRuleMatchContext(RuleMatchContext *ctx, const RuleSet *rs);
+void beginRuleBuffer(RuleMatchContext *ctx, const unsigned char *data, size_t len);
+void beginRuleSegment(RuleMatchContext *ctx, const unsigned char *data, size_t len,
+                      uint64_t base, const unsigned char *prefix, size_t prefix_len);
+void onPrefilterHit(int pattern_id, uint64_t end, void *ctx);
+void printRuleMatchStats(const RuleMatchContext *ctx);
+void addRuleMatchStats(RuleMatchContext *total, const RuleMatchContext *ctx);
+void freeRuleMatchContext(RuleMatchContext *ctx);
+
+#endif  // SRC_PARSE_EVALRULES_H_
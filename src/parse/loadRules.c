@@ -0,0 +1,354 @@
+/*
+ *                 Parallel Multi-File Ruleset Loader
+ *
+ * ---------------------------------------------------------------
+ * Loads a ruleset given as one .rules file or a directory of
+ * them. All files are read back to back into a single buffer,
+ * which becomes the rule text pool, and the buffer is cut into
+ * chunks at rule boundaries (never inside a backslash-continued
+ * rule). Each chunk is parsed on its own thread into a private
+ * RuleSet with its own pattern pool, contents and intern table;
+ * the private sets are then merged in order, so the result is
+ * identical to a single-threaded load.
+ * --------------------------------------------------------------- */
+
+// Define the POSIX source to have access to pthreads, sysconf and dirent
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "loadRules.h"
+
+#define LOAD_MAX_THREADS      64
+#define LOAD_MIN_CHUNK_BYTES  (256 * 1024)
+
+/* ---------------------------------------------------------------
+ *   One chunk of the rule buffer and the private set it fills
+ * --------------------------------------------------------------- */
+typedef struct {
+    RuleSet *rs;
+    size_t   begin;
+    size_t   end;
+} ParseChunk;
+
+/* ---------------------------------------------------------------
+ *   Append a copy of path to the list
+ * --------------------------------------------------------------- */
+static void pushRuleFile(RuleFileList *list, int *cap, const char *path) {
+    if (list->count == *cap) {
+        *cap = *cap ? *cap * 2 : 16;
+        list->paths = realloc(list->paths, (size_t)*cap * sizeof(char *));
+        if (!list->paths) {
+            fprintf(stderr, "Memory allocation failed for rule file list.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    size_t n = strlen(path) + 1;
+    char *copy = malloc(n);
+    if (!copy) {
+        fprintf(stderr, "Memory allocation failed for rule file list.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, path, n);
+    list->paths[list->count++] = copy;
+}
+
+/* ---------------------------------------------------------------
+ *   Recursively add every *.rules file under dir_path
+ * --------------------------------------------------------------- */
+static void collectRuleDir(const char *dir_path, RuleFileList *list, int *cap) {
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        perror(dir_path);
+        return;
+    }
+
+    struct dirent *entry;
+    char path[4096];
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] == '.') continue;
+
+        snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            collectRuleDir(path, list, cap);
+        } else if (S_ISREG(st.st_mode)) {
+            const char *ext = strrchr(entry->d_name, '.');
+            if (ext && strcmp(ext, ".rules") == 0)
+                pushRuleFile(list, cap, path);
+        }
+    }
+    closedir(dir);
+}
+
+static int comparePaths(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* ---------------------------------------------------------------
+ *   Fill out with the rule files named by path (a file or a
+ *   directory). Returns the number of files, or -1 if path does
+ *   not exist.
+ * --------------------------------------------------------------- */
+int collectRuleFiles(const char *path, RuleFileList *out) {
+    out->paths = NULL;
+    out->count = 0;
+
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+
+    int cap = 0;
+    if (S_ISDIR(st.st_mode)) {
+        collectRuleDir(path, out, &cap);
+        qsort(out->paths, (size_t)out->count, sizeof(char *), comparePaths);
+    } else {
+        pushRuleFile(out, &cap, path);
+    }
+    return out->count;
+}
+
+/* ---------------------------------------------------------------
+ *                 Release a list of rule files
+ * --------------------------------------------------------------- */
+void freeRuleFileList(RuleFileList *list) {
+    for (int i = 0; i < list->count; i++) free(list->paths[i]);
+    free(list->paths);
+    list->paths = NULL;
+    list->count = 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Fold n bytes into a 64-bit FNV-1a hash
+ * --------------------------------------------------------------- */
+static uint64_t stampMix(uint64_t h, const void *p, size_t n) {
+    const unsigned char *b = p;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ b[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+/* ---------------------------------------------------------------
+ *   Fold the identity of one stat'ed file into a hash: size,
+ *   mtime to the nanosecond, device and inode
+ * --------------------------------------------------------------- */
+static uint64_t stampFile(uint64_t h, const struct stat *st) {
+    uint64_t v[5] = {
+        (uint64_t)st->st_size,
+        (uint64_t)st->st_mtim.tv_sec,
+        (uint64_t)st->st_mtim.tv_nsec,
+        (uint64_t)st->st_dev,
+        (uint64_t)st->st_ino,
+    };
+    return stampMix(h, v, sizeof(v));
+}
+
+/* ---------------------------------------------------------------
+ *   Identify the current contents of a ruleset path for cache
+ *   validation: a hash over the path itself and, in load order,
+ *   the path, size, mtime and inode of every rule file. Same-size
+ *   edits within a second, files swapped for older ones and
+ *   renames all change it. Returns 0 on success.
+ * --------------------------------------------------------------- */
+int ruleSourceStamp(const char *path, RuleSourceStamp *stamp) {
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+    stamp->size = 0;
+    stamp->hash = stampFile(0xcbf29ce484222325ULL, &st);
+
+    RuleFileList files;
+    if (collectRuleFiles(path, &files) < 0) return -1;
+    for (int i = 0; i < files.count; i++) {
+        stamp->hash = stampMix(stamp->hash, files.paths[i], strlen(files.paths[i]) + 1);
+        if (stat(files.paths[i], &st) != 0) continue;
+        stamp->size += (uint64_t)st.st_size;
+        stamp->hash = stampFile(stamp->hash, &st);
+    }
+    freeRuleFileList(&files);
+    return 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Read every file into one NUL-terminated buffer, each followed
+ *   by a newline so a missing final newline cannot join files.
+ *   Returns NULL if a file cannot be read.
+ * --------------------------------------------------------------- */
+static char *readRuleFiles(const RuleFileList *files, size_t *len_out) {
+    size_t *sizes = malloc(((size_t)files->count + 1) * sizeof(size_t));
+    if (!sizes) {
+        fprintf(stderr, "Memory allocation failed for ruleset buffer.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < files->count; i++) {
+        struct stat st;
+        if (stat(files->paths[i], &st) != 0) {
+            perror(files->paths[i]);
+            free(sizes);
+            return NULL;
+        }
+        sizes[i] = (size_t)st.st_size;
+        total += sizes[i] + 1;
+    }
+    if (total >= UINT32_MAX) {
+        fprintf(stderr, "Ruleset exceeds 4 GB limit.\n");
+        free(sizes);
+        return NULL;
+    }
+
+    char *text = malloc(total + 1);
+    if (!text) {
+        fprintf(stderr, "Memory allocation failed for ruleset buffer.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t len = 0;
+    for (int i = 0; i < files->count; i++) {
+        FILE *fp = fopen(files->paths[i], "rb");
+        if (!fp) {
+            perror(files->paths[i]);
+            free(sizes);
+            free(text);
+            return NULL;
+        }
+        // Read at most the stat'ed size, in case the file grew since
+        len += fread(text + len, 1, sizes[i], fp);
+        fclose(fp);
+        text[len++] = '\n';
+    }
+    text[len] = '\0';
+    free(sizes);
+    *len_out = len;
+    return text;
+}
+
+/* ---------------------------------------------------------------
+ *   First rule boundary at or after pos: just past a newline that
+ *   does not end a backslash-continued line
+ * --------------------------------------------------------------- */
+static size_t ruleBoundary(const char *text, size_t len, size_t pos) {
+    while (pos < len) {
+        const char *eol = memchr(text + pos, '\n', len - pos);
+        if (!eol) return len;
+        size_t at = (size_t)(eol - text);
+        size_t last = (at > 0 && text[at - 1] == '\r') ? at - 1 : at;
+        if (last == 0 || text[last - 1] != '\\') return at + 1;
+        pos = at + 1;
+    }
+    return len;
+}
+
+/* ---------------------------------------------------------------
+ *   Empty RuleSet over the shared text buffer
+ * --------------------------------------------------------------- */
+static RuleSet *newChunkSet(char *text, size_t len) {
+    RuleSet *rs = calloc(1, sizeof(RuleSet));
+    if (!rs) {
+        fprintf(stderr, "Memory allocation failed for RuleSet.\n");
+        exit(EXIT_FAILURE);
+    }
+    rs->ps = createPatternSet();
+    rs->text_pool = text;
+    rs->text_len = len;
+    return rs;
+}
+
+/* ---------------------------------------------------------------
+ *   Release a private chunk set; the shared text is not its own
+ * --------------------------------------------------------------- */
+static void freeChunkSet(RuleSet *rs) {
+    rs->text_pool = NULL;
+    freeRuleSet(rs);
+}
+
+/* ---------------------------------------------------------------
+ *                 Thread entry: parse one chunk
+ * --------------------------------------------------------------- */
+static void *parseChunk(void *arg) {
+    ParseChunk *c = arg;
+    parseRuleLines(c->rs, c->begin, c->end);
+    return NULL;
+}
+
+/* ---------------------------------------------------------------
+ *   Number of threads to use when the caller passes threads <= 0
+ * --------------------------------------------------------------- */
+static int defaultThreads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/* ---------------------------------------------------------------
+ *   Load and parse all rules in files on up to `threads` threads
+ *   (threads <= 0: one per online CPU). Small rulesets are parsed
+ *   on the calling thread.
+ * --------------------------------------------------------------- */
+RuleSet *loadSnortRuleFiles(const RuleFileList *files, int threads) {
+    size_t len = 0;
+    char *text = readRuleFiles(files, &len);
+    if (!text) return NULL;
+
+    if (threads <= 0) threads = defaultThreads();
+    if (threads > LOAD_MAX_THREADS) threads = LOAD_MAX_THREADS;
+    size_t max_chunks = len / LOAD_MIN_CHUNK_BYTES + 1;
+    int nchunks = (size_t)threads < max_chunks ? threads : (int)max_chunks;
+
+    // Chunk 0 parses straight into the result; the rest are merged into it
+    ParseChunk chunks[LOAD_MAX_THREADS];
+    pthread_t tids[LOAD_MAX_THREADS];
+    int started[LOAD_MAX_THREADS] = {0};
+    size_t begin = 0;
+    for (int i = 0; i < nchunks; i++) {
+        size_t end = (i == nchunks - 1) ? len
+                   : ruleBoundary(text, len, len / (size_t)nchunks * (size_t)(i + 1));
+        if (end < begin) end = begin;
+        chunks[i].rs = newChunkSet(text, len);
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        begin = end;
+    }
+
+    for (int i = 1; i < nchunks; i++)
+        started[i] = pthread_create(&tids[i], NULL, parseChunk, &chunks[i]) == 0;
+    parseChunk(&chunks[0]);
+    for (int i = 1; i < nchunks; i++) {
+        if (started[i]) pthread_join(tids[i], NULL);
+        else parseChunk(&chunks[i]);
+    }
+
+    RuleSet *rs = chunks[0].rs;
+    for (int i = 1; i < nchunks; i++) {
+        mergeRuleSet(rs, chunks[i].rs);
+        freeChunkSet(chunks[i].rs);
+    }
+    finalizeRuleSet(rs);
+
+    printf("[*] Parsed %d rules from %d file(s) on %d thread(s)\n",
+           rs->rule_count, files->count, nchunks);
+    return rs;
+}
+
+/* ---------------------------------------------------------------
+ *   Load a ruleset from a .rules file or a directory of them
+ * --------------------------------------------------------------- */
+RuleSet *loadSnortRules(const char *path, int threads) {
+    RuleFileList files;
+    if (collectRuleFiles(path, &files) <= 0) {
+        fprintf(stderr, "[-] No rule files found at %s\n", path);
+        freeRuleFileList(&files);
+        return NULL;
+    }
+    RuleSet *rs = loadSnortRuleFiles(&files, threads);
+    freeRuleFileList(&files);
+    return rs;
+}
@@ -0,0 +1,38 @@
+#ifndef SRC_PARSE_LOADRULES_H_
+#define SRC_PARSE_LOADRULES_H_
+
+#include <stdint.h>
+
+#include "parseRules.h"
+
+/* ---------------------------------------------------------------
+ * RuleFileList:
+ *   The .rules files making up a ruleset, in load order. A single
+ *   file path yields itself; a directory yields every *.rules file
+ *   below it, sorted by path.
+ * --------------------------------------------------------------- */
+typedef struct {
+    char **paths;
+    int    count;
+} RuleFileList;
+
+/* ---------------------------------------------------------------
+ * RuleSourceStamp:
+ *   Identifies the contents of a ruleset path for cache
+ *   validation, see ruleSourceStamp.
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint64_t size;  // total bytes of the rule files
+    uint64_t hash;  // path, size, mtime (ns) and inode of each file
+} RuleSourceStamp;
+
+/* ---------------------------------------------------------------
+ *                     Ruleset Loading API
+ * --------------------------------------------------------------- */
+int      collectRuleFiles(const char *path, RuleFileList *out);
+void     freeRuleFileList(RuleFileList *list);
+int      ruleSourceStamp(const char *path, RuleSourceStamp *stamp);
+RuleSet *loadSnortRuleFiles(const RuleFileList *files, int threads);
+RuleSet *loadSnortRules(const char *path, int threads);
+
+#endif  // SRC_PARSE_LOADRULES_H_
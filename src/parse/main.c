@@ -1,6 +1,6 @@
-// Define the POSIX source to have access to clock_gettime and CLOCK_MONOTONIC
+// Define the POSIX source to have access to clock_gettime, CLOCK_MONOTONIC and scandir
 #if !defined(_WIN32) || defined(__CYGWIN__)
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200809L
 #endif
 
 #include <string.h>
@@ -9,28 +9,35 @@
 #include <time.h>
 #include <dirent.h>
 #include <inttypes.h>
+#include <signal.h>
 #include <sys/stat.h>
 
-#include "../algorithms/WM/wm.h"
-#include "../algorithms/AC/ac.h"
-#include "../algorithms/SH/sh.h"
-#include "../algorithms/BM/bm.h"
+#include "../algorithms/matcher.h"
 #include "../parse/analytics.h"
 #include "../parse/parseRules.h"
+#include "../parse/evalRules.h"
+#include "../parse/ruleCache.h"
+#include "../parse/ruleGroups.h"
+#include "../parse/ruleReload.h"
+#include "../parse/streamScan.h"
+#include "../capture/captureFile.h"
+#include "../capture/captureReader.h"
+#include "../capture/packetDecode.h"
 
 #define RULESET_PATH "./data/ruleset/snort3-community-rules/snort3-community.rules"
 #define TESTS_PATH   "./data/tests/pcaps"
+#define RULE_CACHE_PATH "./bin/ruleset.cache"
+#define SCAN_CHUNK_BYTES (1u << 20)  // raw (non-capture) files are streamed in 1 MB chunks
+
+static RuleReloader *active_reloader = NULL;
 
 /* ---------------------------------------------------------------
- *                        Algorithm selection
+ *        SIGHUP: rebuild the ruleset in the background
  * --------------------------------------------------------------- */
-typedef enum {
-    ALG_WM_DET,   // Wu–Manber deterministic
-    ALG_WM_PROB,  // Wu–Manber probabilistic
-    ALG_AC,       // Aho–Corasick
-    ALG_SH,       // Set–Horspool
-    ALG_BM        // Boyer-Moore
-} AlgorithmType;
+static void on_sighup(int sig) {
+    (void)sig;
+    requestRuleReload(active_reloader);
+}
 
 // /* ---------------------------------------------------------------
 //  *              Prompt user to choose algorithm
@@ -57,58 +64,117 @@ typedef enum {
 // }
 
 /* ---------------------------------------------------------------
- *          Scan a single file with chosen algorithm
+ *            Packet-level counters for one capture
  * --------------------------------------------------------------- */
-static void scan_file(const char *filepath, PatternSet *ps,
-                      WuManberTables *tbl, AhoCorasick *ac,
-                      Pattern *sh_patterns, int sh_count, BMPatterns *bm,
-                      AlgorithmType alg) {
-    FILE *fp = fopen(filepath, "rb");
-    if (!fp) return;
-
-    fseek(fp, 0, SEEK_END);
-    int64_t size = ftell(fp);
-    rewind(fp);
-    if (size <= 0) {
-        fclose(fp);
-        return;
+typedef struct {
+    uint64_t packets;
+    uint64_t decoded;
+    uint64_t payload_packets;
+    uint64_t payload_bytes;
+} CaptureStats;
+
+/* ---------------------------------------------------------------
+ *   Totals over every file of a directory scan. rm holds only the
+ *   summed counters of each file's RuleMatchContext.
+ * --------------------------------------------------------------- */
+typedef struct {
+    int              files;
+    double           elapsed;
+    RuleMatchContext rm;
+    CaptureStats     cs;
+    uint64_t         stream_bytes;
+} ScanTotals;
+
+/* ---------------------------------------------------------------
+ *   Decode every packet of a capture and scan its L7 payload with
+ *   the rule groups selected by its protocol and ports. TCP
+ *   payloads are scanned as reassembled per-flow streams, all
+ *   others packet by packet.
+ * --------------------------------------------------------------- */
+static void scan_packets(CaptureReader *reader, StreamScanner *ss,
+                         const RuleGroupTable *groups, RuleMatchContext *rm,
+                         CaptureStats *cs) {
+    PcapPacket pkt;
+    DecodedPacket dp;
+    int rc;
+    while ((rc = nextCapturePacket(reader, &pkt)) == 1) {
+        cs->packets++;
+        if (!decodePacket(pkt.linktype, pkt.data, pkt.caplen, &dp))
+            continue;
+        cs->decoded++;
+        cs->payload_bytes += dp.payload_len;
+        if (dp.payload_len > 0) cs->payload_packets++;
+
+        if (dp.ip_proto == IPPROTO_NUM_TCP) {
+            scanTcpPacket(ss, &dp, (uint64_t)pkt.ts_sec * 1000000000ull + pkt.ts_nsec);
+            continue;
+        }
+        if (dp.payload_len == 0) continue;
+
+        const RuleGroup *selected[2];
+        int n = selectRuleGroups(groups, dp.ip_proto, dp.src_port, dp.dst_port, selected);
+        beginRuleBuffer(rm, dp.payload, dp.payload_len);
+        for (int g = 0; g < n; g++)
+            scanRuleGroup(selected[g], rm);
     }
+    if (rc < 0)
+        fprintf(stderr, "[!] Truncated capture record after %" PRIu64 " packets\n",
+                cs->packets);
+}
 
-    char *buffer = malloc((size_t)size + 1);
-    if (!buffer) {
-        fclose(fp);
-        return;
+/* ---------------------------------------------------------------
+ *       Print packet counts and payload-level throughput
+ * --------------------------------------------------------------- */
+static void print_capture_stats(const CaptureStats *cs, double elapsed) {
+    printf("\n[Capture]\n");
+    printf("  Packets                : %" PRIu64 "\n", cs->packets);
+    printf("  Decoded IP packets     : %" PRIu64 "\n", cs->decoded);
+    printf("  Packets with payload   : %" PRIu64 "\n", cs->payload_packets);
+    printf("  Payload bytes          : %" PRIu64 "\n", cs->payload_bytes);
+    if (elapsed > 0) {
+        printf("  Packets per second     : %.0f\n", (double)cs->packets / elapsed);
+        printf("  Payload throughput     : %.2f MB/s\n",
+               ((double)cs->payload_bytes / BYTES_PER_MB) / elapsed);
     }
-    fread(buffer, 1, (size_t)size, fp);
-    buffer[size] = '\0';
-    fclose(fp);
+}
 
-    const char *alg_name =
-        (alg == ALG_AC) ? "Aho–Corasick" :
-        (alg == ALG_WM_PROB) ? "Wu–Manber (Probabilistic)" :
-        (alg == ALG_SH) ? "Set–Horspool" :
-        (alg == ALG_BM) ? "Boyer-Moore":
-        "Wu–Manber (Deterministic)";
+/* ---------------------------------------------------------------
+ *          Scan a single file with chosen algorithm
+ *
+ *   A pcap or pcapng capture is decoded packet by packet and only
+ *   payloads are scanned. Any other file has no decoded 5-tuple,
+ *   so its raw bytes are scanned with the all-rules group. The
+ *   file is memory-mapped and scanned in place. If totals is not
+ *   NULL the file's counters are added to it.
+ * --------------------------------------------------------------- */
+static void scan_file(const char *filepath, const RuleSet *rs,
+                      const RuleGroupTable *groups, AlgorithmType alg,
+                      int map_flags, ScanTotals *totals) {
+    CaptureFile file;
+    if (openCaptureFile(filepath, map_flags, &file) != 0) return;
 
+    const char *alg_name = matcher_name(alg);
     printf("\n=== Scanning (%s): %s ===\n", alg_name, filepath);
 
+    RuleMatchContext rm;
+    initRuleMatchContext(&rm, rs);
+    rm.engine_stats.algorithm_name = alg_name;
+    CaptureStats cs = {0};
+    CaptureReader reader;
+
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    switch (alg) {
-        case ALG_AC:
-            ac_search(ac, buffer, (size_t)size);
-            break;
-        case ALG_WM_DET:
-        case ALG_WM_PROB:
-            wm_search((const unsigned char *)buffer, (int)size, ps, tbl);
-            break;
-        case ALG_SH:
-            performSetHorspool(buffer, (uint64_t)size, sh_patterns, sh_count);
-            break;
-        case ALG_BM:
-            bm_search(bm, buffer, (size_t)size);
-            break;
+    StreamScanner ss;
+    initStreamScanner(&ss, groups, &rm);
+
+    if (openCaptureReader(&reader, file.data, file.len) == 0) {
+        printf("[*] Capture format: %s\n", captureFormatName(&reader));
+        scan_packets(&reader, &ss, groups, &rm, &cs);
+    } else {
+        beginRuleBuffer(&rm, file.data, file.len);
+        scanRuleGroupChunked(allRulesGroup(groups), &rm, SCAN_CHUNK_BYTES);
+        cs.payload_bytes = (uint64_t)file.len;
     }
 
     clock_gettime(CLOCK_MONOTONIC, &end);
@@ -116,46 +182,90 @@ static void scan_file(const char *filepath, PatternSet *ps,
                      (double)(end.tv_nsec - start.tv_nsec) / 1e9;
     printf("[+] %s Completed in %.6f seconds\n", alg_name, elapsed);
 
-    free(buffer);
+    compute_throughput(&rm.engine_stats);
+    print_algorithm_stats(&rm.engine_stats);
+    printRuleMatchStats(&rm);
+    print_capture_stats(&cs, elapsed);
+    if (ss.tcp.segments) printStreamScanStats(&ss);
+
+    if (totals) {
+        totals->files++;
+        totals->elapsed += elapsed;
+        addRuleMatchStats(&totals->rm, &rm);
+        totals->cs.packets += cs.packets;
+        totals->cs.decoded += cs.decoded;
+        totals->cs.payload_packets += cs.payload_packets;
+        totals->cs.payload_bytes += cs.payload_bytes;
+        totals->stream_bytes += ss.tcp.bytes_delivered;
+    }
+
+    freeStreamScanner(&ss);
+    freeRuleMatchContext(&rm);
+    closeCaptureFile(&file);
 }
 
-// /* ---------------------------------------------------------------
-//  *            Walk directory and scan all .pcap files
-//  * --------------------------------------------------------------- */
-// static void walk_directory(const char *base_path, PatternSet *ps,
-//                            WuManberTables *tbl, AhoCorasick *ac,
-//                            Pattern *sh_patterns, int sh_count, BMPatterns *bm,
-//                            AlgorithmType alg) {
-//     DIR *dir = opendir(base_path);
-//     if (!dir) return;
-
-//     struct dirent *entry;
-//     char path[1024];
-
-//     while ((entry = readdir(dir))) {
-//         if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
-//             continue;
-
-//         snprintf(path, sizeof(path), "%s/%s", base_path, entry->d_name);
-//         struct stat st;
-//         if (stat(path, &st) == -1)
-//             continue;
-
-//         if (S_ISDIR(st.st_mode)) {
-//             walk_directory(path, ps, tbl, ac, sh_patterns, sh_count, bm, alg);
-//         } else if (S_ISREG(st.st_mode)) {
-//             const char *ext = strrchr(entry->d_name, '.');
-//             if (ext && strcmp(ext, ".pcap") == 0)
-//                 scan_file(path, ps, tbl, ac, sh_patterns, sh_count, bm, alg);
-//         }
-//     }
-//     closedir(dir)
-// }
+/* ---------------------------------------------------------------
+ *   Walk a directory in name order and scan every .pcap / .pcapng
+ *   file under it with the engine already built. The engine is
+ *   re-read for each file, so a SIGHUP reload takes effect at the
+ *   next file boundary.
+ * --------------------------------------------------------------- */
+static void walk_directory(const char *base_path, RuleReloader *reloader, int reader,
+                           AlgorithmType alg, int map_flags, ScanTotals *totals) {
+    struct dirent **entries;
+    int n = scandir(base_path, &entries, NULL, alphasort);
+    if (n < 0) {
+        perror(base_path);
+        return;
+    }
+
+    char path[4096];
+    for (int i = 0; i < n; i++) {
+        const char *name = entries[i]->d_name;
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", base_path, name);
+        if (name[0] == '.' || stat(path, &st) == -1) {
+            free(entries[i]);
+            continue;
+        }
+
+        if (S_ISDIR(st.st_mode)) {
+            walk_directory(path, reloader, reader, alg, map_flags, totals);
+        } else if (S_ISREG(st.st_mode)) {
+            const char *ext = strrchr(name, '.');
+            if (ext && (strcmp(ext, ".pcap") == 0 || strcmp(ext, ".pcapng") == 0)) {
+                const RuleEngine *engine = ruleReadLock(reloader, reader);
+                scan_file(path, engine->rs, engine->groups, alg, map_flags, totals);
+                ruleReadUnlock(reloader, reader);
+            }
+        }
+        free(entries[i]);
+    }
+    free(entries);
+}
+
+/* ---------------------------------------------------------------
+ *        Print the summed stats of a directory scan
+ * --------------------------------------------------------------- */
+static void print_scan_totals(ScanTotals *totals, AlgorithmType alg) {
+    const char *alg_name = matcher_name(alg);
+    printf("\n=== Aggregate (%s): %d files ===\n", alg_name, totals->files);
+    printf("[+] %s Completed in %.6f seconds\n", alg_name, totals->elapsed);
+
+    totals->rm.engine_stats.algorithm_name = alg_name;
+    compute_throughput(&totals->rm.engine_stats);
+    print_algorithm_stats(&totals->rm.engine_stats);
+    printRuleMatchStats(&totals->rm);
+    print_capture_stats(&totals->cs, totals->elapsed);
+    if (totals->stream_bytes)
+        printf("  Stream bytes scanned   : %" PRIu64 "\n", totals->stream_bytes);
+}
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <algorithm_choice> <file_to_scan>\n", argv[0]);
-        fprintf(stderr, "Algorithm choices: a, d, p, h\n");
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <algorithm_choice> <file_or_directory> "
+                        "[--populate] [--hugepages]\n", argv[0]);
+        fprintf(stderr, "Algorithm choices: a, f, s, c, d, p, h, b\n");
         return EXIT_FAILURE;
     }
 
@@ -163,8 +273,23 @@ int main(int argc, char *argv[]) {
     const char *filepath = argv[2];
     AlgorithmType alg;
 
+    int map_flags = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--populate") == 0) {
+            map_flags |= CAPTURE_MAP_POPULATE;
+        } else if (strcmp(argv[i], "--hugepages") == 0) {
+            map_flags |= CAPTURE_MAP_HUGEPAGES;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
     switch (choice) {
         case 'a': alg = ALG_AC; break;
+        case 'f': alg = ALG_AC_DFA; break;
+        case 's': alg = ALG_AC_HYBRID; break;
+        case 'c': alg = ALG_AC_DA; break;
         case 'd': alg = ALG_WM_DET; break;
         case 'p': alg = ALG_WM_PROB; break;
         case 'h': alg = ALG_SH; break;
@@ -174,95 +299,70 @@ int main(int argc, char *argv[]) {
             return EXIT_FAILURE;
     }
 
-    PatternSet *ps = loadSnortRulesFromFile(RULESET_PATH);
-    if (!ps) {
+    // Engines are built once per rule group; name the mode once here
+    printf("[*] Matching engine: %s\n", matcher_name(alg));
+
+    global_mem_stats = calloc(1, sizeof(MemoryStats));
+
+    struct timespec build_start, build_end;
+    double preprocessing_time = 0.0;
+
+    clock_gettime(CLOCK_MONOTONIC, &build_start);
+    RuleReloader *reloader = startRuleReloader(RULESET_PATH, RULE_CACHE_PATH, alg);
+    clock_gettime(CLOCK_MONOTONIC, &build_end);
+    if (!reloader) {
         fprintf(stderr, "[-] Failed to load rules from %s\n", RULESET_PATH);
+        free(global_mem_stats);
         return EXIT_FAILURE;
     }
 
+    // Rules are rebuilt on SIGHUP without stalling the scan; a reload
+    // must not make a blocked write to stdout fail with EINTR
+    active_reloader = reloader;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sighup;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGHUP, &sa, NULL);
+
+    int reader = ruleReaderRegister(reloader);
+    const RuleEngine *engine = ruleReadLock(reloader, reader);
+    const PatternSet *ps = engine->rs->ps;
+
     // Calculate and print ruleset stats
     uint64_t total_pattern_length = 0;
     for (int i = 0; i < ps->pattern_count; i++) {
-        total_pattern_length += strlen(ps->patterns[i]);
+        total_pattern_length += (uint64_t)ps->pattern_lens[i];
     }
     double avg_pattern_length = (ps->pattern_count > 0) ? (double)total_pattern_length / (double)ps->pattern_count : 0.0;
 
     printf("Ruleset-Count: %d\n", ps->pattern_count);
     printf("Ruleset-Avg-Length: %.2f\n", avg_pattern_length);
-
-    global_mem_stats = calloc(1, sizeof(MemoryStats));
-
-    struct timespec build_start, build_end;
-    double preprocessing_time = 0.0;
-
-    switch (alg) {
-        case ALG_AC: {
-            AhoCorasick *ac = ac_create();
-            clock_gettime(CLOCK_MONOTONIC, &build_start);
-            for (int i = 0; i < ps->pattern_count; i++)
-                ac_add_pattern(ac, ps->patterns[i]);
-            ac_build(ac);
-
-            clock_gettime(CLOCK_MONOTONIC, &build_end);
-            scan_file(filepath, ps, NULL, ac, NULL, 0, NULL, ALG_AC);
-            ac_destroy(ac);
-            break;
-        }
-
-        case ALG_WM_DET:
-        case ALG_WM_PROB: {
-            int use_bloom = (alg == ALG_WM_PROB);
-            WuManberTables *tbl = track_malloc(sizeof(WuManberTables));
-            clock_gettime(CLOCK_MONOTONIC, &build_start);
-            wm_build_tables(ps, tbl, use_bloom);
-            clock_gettime(CLOCK_MONOTONIC, &build_end);
-            scan_file(filepath, ps, tbl, NULL, NULL, 0, NULL, alg);
-            wm_free_tables(tbl);
-            track_free(tbl);
-            break;
-        }
-
-        case ALG_SH: {
-            Pattern *sh_patterns = track_calloc((size_t)ps->pattern_count, sizeof(Pattern));
-            clock_gettime(CLOCK_MONOTONIC, &build_start);
-            for (int i = 0; i < ps->pattern_count; i++) {
-                sh_patterns[i].pattern = ps->patterns[i];
-                sh_patterns[i].length = (int)strlen(ps->patterns[i]);
-                sh_patterns[i].id = i;
-                sh_patterns[i].nocase = 0;
-            }
-            clock_gettime(CLOCK_MONOTONIC, &build_end);
-            scan_file(filepath, ps, NULL, NULL, sh_patterns, ps->pattern_count,
-                NULL, ALG_SH);
-            track_free(sh_patterns);
-            break;
-        }
-
-        case ALG_BM: {
-            printf("[+] Pre-processing all patterns for Boyer-Moore...\n");
-            clock_gettime(CLOCK_MONOTONIC, &build_start);
-            BMPatterns *bm = bm_preprocessing(ps);
-            clock_gettime(CLOCK_MONOTONIC, &build_end);
-
-            printf("\n[+] Scanning all files under: %s\n", TESTS_PATH);
-            scan_file(filepath, ps, NULL, NULL, NULL, 0, bm, ALG_BM);
-            // free all tables
-            bm_free_tables(bm);
-
-            break;
-        }
+    printf("Rule-Groups: %d\n", engine->groups->group_count);
+
+    // A directory is scanned file by file with the one engine built above
+    struct stat st;
+    if (stat(filepath, &st) == 0 && S_ISDIR(st.st_mode)) {
+        ruleReadUnlock(reloader, reader);
+        ScanTotals totals;
+        memset(&totals, 0, sizeof(totals));
+        walk_directory(filepath, reloader, reader, alg, map_flags, &totals);
+        print_scan_totals(&totals, alg);
+    } else {
+        scan_file(filepath, engine->rs, engine->groups, alg, map_flags, NULL);
+        ruleReadUnlock(reloader, reader);
     }
 
     preprocessing_time = (double)(build_end.tv_sec - build_start.tv_sec) +
                          (double)(build_end.tv_nsec - build_start.tv_nsec) / 1e9;
     printf("Preprocessing-Time: %.6f\n", preprocessing_time);
 
-    print_memory_stats("Active Algorithm", global_mem_stats);
+    sa.sa_handler = SIG_DFL;
+    sigaction(SIGHUP, &sa, NULL);
+    active_reloader = NULL;
+    stopRuleReloader(reloader);
 
-    for (int i = 0; i < ps->pattern_count; i++)
-        free(ps->rule_refs[i]);
-    free(ps->rule_refs);
-    free(ps);
+    print_memory_stats("Active Algorithm", global_mem_stats);
 
     free(global_mem_stats);
 
@@ -4,96 +4,792 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <ctype.h>
+#include <sys/mman.h>
 
 #include "parseRules.h"
 #include "trim.c"
 
 #define CONTENT_START 9
+#define INITIAL_POOL_BYTES   (64 * 1024)
+#define INITIAL_PATTERN_CAP  1024
 
+/* -------------------------------------------------------------------------
+ *   Allocates an empty PatternSet with a small initial pool and index.
+ *   Both grow geometrically as patterns are added.
+ * ------------------------------------------------------------------------- */
+PatternSet *createPatternSet(void) {
+    PatternSet *ps = calloc(1, sizeof(PatternSet));
+    if (!ps) {
+        fprintf(stderr, "Memory allocation failed for PatternSet.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    ps->pool_cap = INITIAL_POOL_BYTES;
+    ps->pattern_cap = INITIAL_PATTERN_CAP;
+    ps->pool = malloc(ps->pool_cap);
+    ps->offsets = malloc((size_t)ps->pattern_cap * sizeof(uint32_t));
+    ps->pattern_lens = malloc((size_t)ps->pattern_cap * sizeof(int));
+    ps->nocase = malloc((size_t)ps->pattern_cap * sizeof(uint8_t));
+    if (!ps->pool || !ps->offsets || !ps->pattern_lens || !ps->nocase) {
+        fprintf(stderr, "Memory allocation failed for PatternSet pool.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ps;
+}
+
+/* -------------------------------------------------------------------------
+ *   Ensures at least `extra` free bytes at the end of the pattern pool
+ *   and returns a pointer to that free tail.
+ * ------------------------------------------------------------------------- */
+static unsigned char *reservePoolBytes(PatternSet *ps, size_t extra) {
+    if (ps->pool_len + extra > ps->pool_cap) {
+        size_t cap = ps->pool_cap;
+        while (ps->pool_len + extra > cap) cap *= 2;
+        if (cap > UINT32_MAX) {
+            fprintf(stderr, "Pattern pool exceeds 4 GB limit.\n");
+            exit(EXIT_FAILURE);
+        }
+        ps->pool = realloc(ps->pool, cap);
+        if (!ps->pool) {
+            fprintf(stderr, "Memory allocation failed for pattern pool.\n");
+            exit(EXIT_FAILURE);
+        }
+        ps->pool_cap = cap;
+    }
+    return ps->pool + ps->pool_len;
+}
+
+/* -------------------------------------------------------------------------
+ *   Adds an index entry for `len` pool bytes starting at `offset` as a new
+ *   prefilter pattern and returns the pattern index.
+ * ------------------------------------------------------------------------- */
+static int indexPattern(PatternSet *ps, uint32_t offset, int len, int nocase) {
+    if (ps->pattern_count >= ps->pattern_cap) {
+        ps->pattern_cap *= 2;
+        size_t n = (size_t)ps->pattern_cap;
+        ps->offsets = realloc(ps->offsets, n * sizeof(uint32_t));
+        ps->pattern_lens = realloc(ps->pattern_lens, n * sizeof(int));
+        ps->nocase = realloc(ps->nocase, n * sizeof(uint8_t));
+        if (!ps->offsets || !ps->pattern_lens || !ps->nocase) {
+            fprintf(stderr, "Memory allocation failed for pattern index.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int id = ps->pattern_count++;
+    ps->offsets[id] = offset;
+    ps->pattern_lens[id] = len;
+    ps->nocase[id] = (uint8_t)(nocase != 0);
+    return id;
+}
+
+/* -------------------------------------------------------------------------
+ *   Copies `len` bytes into the pool of ps and indexes them as a new
+ *   prefilter pattern. Returns the pattern index.
+ * ------------------------------------------------------------------------- */
+int addPatternToSet(PatternSet *ps, const unsigned char *bytes, int len, int nocase) {
+    unsigned char *dst = reservePoolBytes(ps, (size_t)len);
+    memcpy(dst, bytes, (size_t)len);
+    uint32_t offset = (uint32_t)ps->pool_len;
+    ps->pool_len += (size_t)len;
+    return indexPattern(ps, offset, len, nocase);
+}
+
+/* -------------------------------------------------------------------------
+ *   FNV-1a hash of a literal and its case flag, for pattern interning
+ * ------------------------------------------------------------------------- */
+static uint64_t literalHash(const unsigned char *bytes, int len, int nocase) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ (uint64_t)(nocase != 0);
+    for (int i = 0; i < len; i++)
+        h = (h ^ bytes[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+/* -------------------------------------------------------------------------
+ *   Doubles the intern table and reinserts every pattern
+ * ------------------------------------------------------------------------- */
+static void growInternTable(RuleSet *rs) {
+    const PatternSet *ps = rs->ps;
+    size_t cap = rs->intern_cap ? rs->intern_cap * 2 : (size_t)INITIAL_PATTERN_CAP * 2;
+    int *slots = calloc(cap, sizeof(int));
+    if (!slots) {
+        fprintf(stderr, "Memory allocation failed for pattern intern table.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int id = 0; id < ps->pattern_count; id++) {
+        uint64_t h = literalHash(ps_pattern(ps, id), ps->pattern_lens[id], ps->nocase[id]);
+        size_t i = (size_t)h & (cap - 1);
+        while (slots[i]) i = (i + 1) & (cap - 1);
+        slots[i] = id + 1;
+    }
+
+    free(rs->intern);
+    rs->intern = slots;
+    rs->intern_cap = cap;
+}
+
+/* -------------------------------------------------------------------------
+ *   Returns the index of the pattern with exactly these bytes and case
+ *   flag, adding it to the PatternSet only if it is not already there.
+ *   The table is kept at most half full.
+ * ------------------------------------------------------------------------- */
+static int internPattern(RuleSet *rs, uint32_t offset, int len, int nocase) {
+    PatternSet *ps = rs->ps;
+    if ((size_t)(ps->pattern_count + 1) * 2 > rs->intern_cap) growInternTable(rs);
+
+    const unsigned char *bytes = ps->pool + offset;
+    size_t mask = rs->intern_cap - 1;
+    size_t i = (size_t)literalHash(bytes, len, nocase) & mask;
+    for (; rs->intern[i]; i = (i + 1) & mask) {
+        int id = rs->intern[i] - 1;
+        if (ps->pattern_lens[id] == len && ps->nocase[id] == (uint8_t)(nocase != 0) &&
+            memcmp(ps_pattern(ps, id), bytes, (size_t)len) == 0)
+            return id;
+    }
+
+    int id = indexPattern(ps, offset, len, nocase);
+    rs->intern[i] = id + 1;
+    return id;
+}
+
+/* -------------------------------------------------------------------------
+ *   Releases a PatternSet together with its pool and index.
+ * ------------------------------------------------------------------------- */
+void freePatternSet(PatternSet *ps) {
+    if (!ps) return;
+    free(ps->rule_start);
+    free(ps->rule_ids);
+    free(ps->pattern_lens);
+    free(ps->nocase);
+    free(ps->offsets);
+    free(ps->pool);
+    free(ps);
+}
+
+/* -------------------------------------------------------------------------
+ *   Converts a single ASCII hex digit to its value, or -1 if the
+ *   character is not a hex digit.
+ * ------------------------------------------------------------------------- */
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* -------------------------------------------------------------------------
+ *   Returns a pointer to the closing quote of a content string, skipping
+ *   backslash-escaped characters (e.g. \" and \;), or NULL if unterminated.
+ * ------------------------------------------------------------------------- */
+static char *findContentEnd(char *content) {
+    for (char *p = content; *p; p++) {
+        if (*p == '\\' && p[1] != '\0') {
+            p++;
+            continue;
+        }
+        if (*p == '"') return p;
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------
+ *   Decodes the raw text of a Snort content string into the bytes it
+ *   actually matches. Hex sections such as |00 0D 0A| become raw bytes
+ *   (including embedded NULs) and backslash escapes (\" \; \\) yield the
+ *   escaped character.
+ *
+ *   Returns the decoded length, or -1 if the content is malformed or does
+ *   not fit into out_cap bytes.
+ * ------------------------------------------------------------------------- */
+int decodeContent(const char *src, size_t src_len, unsigned char *out, size_t out_cap) {
+    size_t n = 0;
+    int in_hex = 0;
+    int high = -1;      // pending high nibble inside a hex section
+
+    for (size_t i = 0; i < src_len; i++) {
+        char c = src[i];
+
+        if (in_hex) {
+            if (c == '|') {
+                if (high != -1) return -1;  // odd number of hex digits
+                in_hex = 0;
+            } else if (c == ' ') {
+                if (high != -1) return -1;  // byte split by whitespace
+            } else {
+                int v = hexValue(c);
+                if (v < 0) return -1;
+                if (high == -1) {
+                    high = v;
+                } else {
+                    if (n >= out_cap) return -1;
+                    out[n++] = (unsigned char)((high << 4) | v);
+                    high = -1;
+                }
+            }
+            continue;
+        }
+
+        if (c == '|') {
+            in_hex = 1;
+            continue;
+        }
+        if (c == '\\') {
+            if (++i >= src_len) return -1;
+            c = src[i];
+        }
+        if (n >= out_cap) return -1;
+        out[n++] = (unsigned char)c;
+    }
+
+    if (in_hex) return -1;  // unterminated hex section
+    return (int)n;
+}
+
+/* -------------------------------------------------------------------------
+ *   Parses the numeric argument of a modifier such as "depth 4" or
+ *   "depth:4". Non-numeric arguments (byte_extract variables) yield 0.
+ * ------------------------------------------------------------------------- */
+static int modifierValue(const char *arg, const char *end) {
+    while (arg < end && (*arg == ' ' || *arg == ':')) arg++;
+    if (arg >= end) return 0;
+    char *num_end;
+    long v = strtol(arg, &num_end, 10);
+    if (num_end == arg || num_end > end) return 0;
+    if (v > INT32_MAX) v = INT32_MAX;
+    if (v < -INT32_MAX) v = -INT32_MAX;
+    return (int)v;
+}
+
+/* -------------------------------------------------------------------------
+ *   Applies one modifier token (e.g. "nocase" or "depth 4") to mods.
+ *   Returns 1 if the keyword is a content modifier, 0 otherwise.
+ * ------------------------------------------------------------------------- */
+static int applyContentModifier(const char *tok, size_t len, ContentModifiers *mods) {
+    size_t kw = 0;
+    while (kw < len && (isalnum((unsigned char)tok[kw]) || tok[kw] == '_'))
+        kw++;
+    const char *arg = tok + kw;
+    const char *end = tok + len;
+
+    if (kw == 6 && strncmp(tok, "nocase", kw) == 0) {
+        mods->nocase = 1;
+        return 1;
+    }
+    if (kw == 12 && strncmp(tok, "fast_pattern", kw) == 0) {
+        mods->fast_pattern = 1;
+        return 1;
+    }
+    if (kw == 6 && strncmp(tok, "offset", kw) == 0) {
+        mods->offset = modifierValue(arg, end);
+        return 1;
+    }
+    if (kw == 5 && strncmp(tok, "depth", kw) == 0) {
+        mods->depth = modifierValue(arg, end);
+        return 1;
+    }
+    if (kw == 8 && strncmp(tok, "distance", kw) == 0) {
+        mods->distance = modifierValue(arg, end);
+        mods->relative = 1;
+        return 1;
+    }
+    if (kw == 6 && strncmp(tok, "within", kw) == 0) {
+        mods->within = modifierValue(arg, end);
+        mods->relative = 1;
+        return 1;
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------------
+ *   Returns the length of the rule option starting at opt, up to but not
+ *   including its terminating ';'. Quoted strings (as in msg or pcre) may
+ *   hold ';' and backslash-escaped characters.
+ * ------------------------------------------------------------------------- */
+static size_t optionLength(const char *opt) {
+    int quoted = 0;
+    size_t i = 0;
+    for (; opt[i]; i++) {
+        if (opt[i] == '\\' && opt[i + 1] != '\0') {
+            i++;
+            continue;
+        }
+        if (opt[i] == '"') quoted = !quoted;
+        else if (opt[i] == ';' && !quoted) break;
+    }
+    return i;
+}
+
+/* -------------------------------------------------------------------------
+ *   Returns 1 if the option starts a new content (content: or a keyword
+ *   ending in it, such as uricontent:), which ends the previous content's
+ *   modifiers.
+ * ------------------------------------------------------------------------- */
+static int isContentOption(const char *opt, size_t len) {
+    size_t kw = 0;
+    while (kw < len && (isalnum((unsigned char)opt[kw]) || opt[kw] == '_'))
+        kw++;
+    return kw >= 7 && kw < len && opt[kw] == ':' &&
+           strncmp(opt + kw - 7, "content", 7) == 0;
+}
+
+/* -------------------------------------------------------------------------
+ *   Parses the modifiers that follow a content string, starting just after
+ *   its closing quote. Both Snort 3 style (content:"x",nocase;) and Snort 2
+ *   style (content:"x"; nocase;) are accepted. Snort 2 modifiers may be
+ *   mixed with other options (content:"x"; http_uri; nocase;), so every
+ *   option up to the next content or the end of the rule is looked at and
+ *   unknown ones are skipped. Returns a pointer past the last option read.
+ * ------------------------------------------------------------------------- */
+static const char *parseContentModifiers(const char *p, ContentModifiers *mods) {
+    memset(mods, 0, sizeof(*mods));
+
+    // Snort 3: comma separated list inside the content option itself
+    while (*p == ',') {
+        p++;
+        while (*p == ' ') p++;
+        size_t n = strcspn(p, ",;");
+        applyContentModifier(p, n, mods);
+        p += n;
+    }
+    if (*p == ';') p++;
+
+    // Snort 2: modifiers given as standalone options after the content
+    for (;;) {
+        const char *q = p;
+        while (*q == ' ') q++;
+        size_t n = optionLength(q);
+        if (q[n] != ';' || isContentOption(q, n))
+            break;
+        applyContentModifier(q, n, mods);
+        p = q + n + 1;
+    }
+    return p;
+}
+
+/* -------------------------------------------------------------------------
+ *   Picks the content used as the rule's single prefilter literal. An
+ *   explicit fast_pattern wins; otherwise the longest positive content is
+ *   used, preferring case-sensitive contents on ties as they are more
+ *   selective. Negated contents can never anchor a rule. Returns -1 if
+ *   the rule has no positive content.
+ * ------------------------------------------------------------------------- */
+static int selectFastPattern(const RuleContent *contents, int count) {
+    int best = -1;
+    for (int i = 0; i < count; i++) {
+        const RuleContent *c = &contents[i];
+        if (c->mods.negated) continue;
+        if (c->mods.fast_pattern) return i;
+
+        if (best == -1 ||
+            c->length > contents[best].length ||
+            (c->length == contents[best].length &&
+             !c->mods.nocase && contents[best].mods.nocase))
+            best = i;
+    }
+    return best;
+}
+
+/* -------------------------------------------------------------------------
+ *   Counts the content options in a rule, an upper bound on how many
+ *   RuleContent entries it needs.
+ * ------------------------------------------------------------------------- */
+static int countContents(const char *snortRule) {
+    int n = 0;
+    for (const char *p = strstr(snortRule, "content:"); p; p = strstr(p + 8, "content:"))
+        n++;
+    return n;
+}
+
+/* -------------------------------------------------------------------------
+ *   Finds option `name` (e.g. "sid") in a rule's option list and returns
+ *   a pointer to its argument, or NULL. The name must start an option,
+ *   so "sid:" does not match inside another option's name.
+ * ------------------------------------------------------------------------- */
+static const char *findRuleOption(const char *options, const char *name) {
+    size_t n = strlen(name);
+    for (const char *p = strstr(options, name); p; p = strstr(p + 1, name)) {
+        int at_start = (p == options || p[-1] == ';' || isspace((unsigned char)p[-1]));
+        if (at_start && p[n] == ':') {
+            p += n + 1;
+            while (isspace((unsigned char)*p)) p++;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------
+ *   Fills in the rule table fields that locate a rule's header, option
+ *   list and msg inside its text, plus its sid and rev. Returns -1 if the
+ *   text has no parenthesised option list.
+ * ------------------------------------------------------------------------- */
+static int parseRuleLayout(char *text, SnortRule *rule) {
+    char *lparen = strchr(text, '(');
+    char *rparen = strrchr(text, ')');
+    if (!lparen || !rparen || rparen < lparen) return -1;
+
+    const char *hdr_end = lparen;
+    while (hdr_end > text && isspace((unsigned char)hdr_end[-1])) hdr_end--;
+    rule->header_len = (uint32_t)(hdr_end - text);
+    rule->options_offset = (uint32_t)(lparen + 1 - text);
+    rule->options_len = (uint32_t)(rparen - lparen - 1);
+
+    const char *options = lparen + 1;
+    const char *arg = findRuleOption(options, "sid");
+    rule->sid = arg ? (uint32_t)strtoul(arg, NULL, 10) : 0;
+    arg = findRuleOption(options, "rev");
+    rule->rev = arg ? (uint32_t)strtoul(arg, NULL, 10) : 0;
+
+    rule->msg_offset = 0;
+    rule->msg_len = 0;
+    arg = findRuleOption(options, "msg");
+    if (arg && *arg == '"') {
+        char *msg = (char *)arg + 1;
+        char *msg_end = findContentEnd(msg);
+        if (msg_end) {
+            rule->msg_offset = (uint32_t)(msg - text);
+            rule->msg_len = (uint32_t)(msg_end - msg);
+        }
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------------
+ *   Ensures room for `extra` more entries in the rule table
+ * ------------------------------------------------------------------------- */
+static void reserveRules(RuleSet *rs, int extra) {
+    if (rs->rule_count + extra <= rs->rule_cap) return;
+    int cap = rs->rule_cap ? rs->rule_cap : INITIAL_PATTERN_CAP;
+    while (rs->rule_count + extra > cap) cap *= 2;
+    rs->rules = realloc(rs->rules, (size_t)cap * sizeof(SnortRule));
+    if (!rs->rules) {
+        fprintf(stderr, "Memory allocation failed for rule table.\n");
+        exit(EXIT_FAILURE);
+    }
+    rs->rule_cap = cap;
+}
+
+/* -------------------------------------------------------------------------
+ *   Ensures room for `extra` more rule contents
+ * ------------------------------------------------------------------------- */
+static void reserveContents(RuleSet *rs, int extra) {
+    if (rs->content_count + extra <= rs->content_cap) return;
+    int cap = rs->content_cap ? rs->content_cap : INITIAL_PATTERN_CAP;
+    while (rs->content_count + extra > cap) cap *= 2;
+    rs->contents = realloc(rs->contents, (size_t)cap * sizeof(RuleContent));
+    if (!rs->contents) {
+        fprintf(stderr, "Memory allocation failed for rule contents.\n");
+        exit(EXIT_FAILURE);
+    }
+    rs->content_cap = cap;
+}
 
 /* -------------------------------------------------------------------------
- *   Parses a single Snort rule line and extracts one or more `content:"..."`
- *   strings from it. Each extracted content string is added to the given
- *   Wu–Manber PatternSet for later table construction.
+ *   Parses the NUL-terminated Snort rule at text_offset in rs->text_pool
+ *   and extracts every `content:"..."` string from it. Each content is
+ *   decoded into raw bytes in the PatternSet pool and recorded, with its
+ *   modifiers, on a new rule. Only the rule's fast pattern is indexed as
+ *   a prefilter pattern; the other contents are kept on the rule and
+ *   checked after a prefilter hit.
+ *
+ *   Returns the new rule index, or -1 if the rule has no usable content.
  *
  * References:
  *   Snort rule format overview:
  *     https://www.splunk.com/en_us/blog/learn/snort-rules.html
  *   Snort payload options:
  *     https://docs.snort.org/rules/options/payload/
+ *   Snort fast_pattern selection:
+ *     https://docs.snort.org/rules/options/payload/fast_pattern
  * ------------------------------------------------------------------------- */
-PatternSet *addContentToTable(char *snortRule, PatternSet *ps, int *currPattern) {
+int addRuleToSet(RuleSet *rs, uint32_t text_offset) {
+    PatternSet *ps = rs->ps;
+    char *snortRule = rs->text_pool + text_offset;
+    int max_contents = countContents(snortRule);
+    if (max_contents == 0) return -1;
+
+    SnortRule layout;
+    if (parseRuleLayout(snortRule, &layout) != 0) return -1;
+
+    reserveContents(rs, max_contents);
+    // Fill the free tail directly; it is only committed if the rule is kept
+    RuleContent *contents = rs->contents + rs->content_count;
+
+    int count = 0;
     char *ptr = strstr(snortRule, "content:");
     while (ptr) {
-        // Skip negative content patterns (content:!)
-        if (ptr[8] == '!') {
-            ptr = strstr(ptr + 1, "content:");
+        int negated = (ptr[8] == '!');
+        char *content = &ptr[CONTENT_START + negated];
+        if (content[-1] != '"') {
+            ptr = strstr(ptr + 8, "content:");
             continue;
         }
-
-        char *content = &ptr[CONTENT_START];
-        char *content_end = strstr(content, "\"");
+        char *content_end = findContentEnd(content);
         if (!content_end) break;
 
-        size_t len = (size_t)(content_end - content);
-        if (len >= MAX_PATTERN_LEN) len = MAX_PATTERN_LEN - 1;
+        // Decoding never produces more bytes than the raw text, so decode
+        // straight into the pool tail and only commit on success.
+        size_t raw_len = (size_t)(content_end - content);
+        unsigned char *dst = reservePoolBytes(ps, raw_len);
+        int len = decodeContent(content, raw_len, dst, raw_len);
 
-        if (len == 0) {
-            // Skip empty patterns
-            ptr = strstr(content_end, "content:");
-            continue;
+        ContentModifiers mods;
+        const char *next = parseContentModifiers(content_end + 1, &mods);
+        mods.negated = negated;
+
+        if (len > 0) {
+            contents[count].offset = (uint32_t)ps->pool_len;
+            contents[count].length = len;
+            contents[count].mods = mods;
+            ps->pool_len += (size_t)len;
+            count++;
         }
+        // Empty or malformed contents are skipped
+
+        ptr = strstr(next, "content:");
+    }
+
+    int fp = selectFastPattern(contents, count);
+    if (fp < 0) {
+        // No positive content: nothing a literal prefilter can key on
+        return -1;
+    }
+
+    reserveRules(rs, 1);
+    int rule_id = rs->rule_count++;
+    SnortRule *rule = &rs->rules[rule_id];
+    *rule = layout;
+    rule->text_offset = text_offset;
+    rule->first_content = (uint32_t)rs->content_count;
+    rule->content_count = count;
+    rule->fast_pattern = fp;
 
-        strncpy(ps->patterns[*currPattern], content, len);
-        ps->patterns[*currPattern][len] = '\0';
+    rs->content_count += count;
+
+    rule->pattern_id = (uint32_t)internPattern(rs, contents[fp].offset, contents[fp].length,
+                                               contents[fp].mods.nocase);
+    return rule_id;
+}
 
-        ps->rule_refs[*currPattern] = strdup(snortRule);
-        ps->pattern_count++;
-        (*currPattern)++;
+/* -------------------------------------------------------------------------
+ *   Parses the rule lines in [begin, end) of rs->text_pool, which must
+ *   start at a line boundary. A line ending in a backslash continues on
+ *   the next one; the backslash and line break are blanked in place so
+ *   the joined rule stays a single string. Lines are NUL-terminated and
+ *   trimmed in place. Returns the number of rules added.
+ * ------------------------------------------------------------------------- */
+int parseRuleLines(RuleSet *rs, size_t begin, size_t end) {
+    char *text = rs->text_pool;
+    int added = 0;
+    size_t pos = begin;
+    while (pos < end) {
+        char *line = text + pos;
+        char *eol = memchr(line, '\n', end - pos);
+        while (eol) {
+            char *last = eol;
+            if (last > line && last[-1] == '\r') last--;
+            if (last == line || last[-1] != '\\') break;
+            // Continuation: blank the backslash and line break, keep scanning
+            memset(last - 1, ' ', (size_t)(eol - last) + 2);
+            eol = memchr(eol + 1, '\n', end - (size_t)(eol + 1 - text));
+        }
+        size_t next = eol ? (size_t)(eol - text) + 1 : end;
+        if (eol) *eol = '\0';
 
-        ptr = strstr(content_end, "content:");
+        trim(line);
+        if (line[0] != '#' && strlen(line) >= 5 &&     // We don't care for comments or empty lines
+            addRuleToSet(rs, (uint32_t)pos) >= 0)
+            added++;
+
+        pos = next;
     }
-    return ps;
+    return added;
 }
 
 /* -------------------------------------------------------------------------
- *   Loads and parses all Snort rules from a specified ruleset file,
- *   automatically extracting every `content:"..."` pattern and storing
- *   it in a Wu–Manber PatternSet.
+ *   Appends the rules of src to dst. Both must share the same text_pool;
+ *   src's pattern bytes and contents are copied and its fast patterns are
+ *   re-interned in dst. src is left unchanged and must not be finalized.
  * ------------------------------------------------------------------------- */
-PatternSet *loadSnortRulesFromFile(const char *filename) {
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        perror(filename);
-        return NULL;
+void mergeRuleSet(RuleSet *dst, const RuleSet *src) {
+    PatternSet *ps = dst->ps;
+    const PatternSet *sps = src->ps;
+
+    size_t pool_base = ps->pool_len;
+    memcpy(reservePoolBytes(ps, sps->pool_len), sps->pool, sps->pool_len);
+    ps->pool_len += sps->pool_len;
+
+    uint32_t content_base = (uint32_t)dst->content_count;
+    reserveContents(dst, src->content_count);
+    for (int i = 0; i < src->content_count; i++) {
+        RuleContent c = src->contents[i];
+        c.offset += (uint32_t)pool_base;
+        dst->contents[dst->content_count++] = c;
     }
 
-    PatternSet *ps = malloc(sizeof(PatternSet));
-    if (!ps) {
-        fprintf(stderr, "Memory allocation failed for PatternSet.\n");
+    int *remap = malloc(((size_t)sps->pattern_count + 1) * sizeof(int));
+    if (!remap) {
+        fprintf(stderr, "Memory allocation failed for rule set merge.\n");
         exit(EXIT_FAILURE);
     }
-    memset(ps, 0, sizeof(PatternSet));
-    ps->rule_refs = malloc(MAX_PATTERNS * sizeof(char *));
-    if (!ps->rule_refs) {
-        fprintf(stderr, "Memory allocation failed for rule_refs.\n");
+    for (int p = 0; p < sps->pattern_count; p++)
+        remap[p] = internPattern(dst, sps->offsets[p] + (uint32_t)pool_base,
+                                 sps->pattern_lens[p], sps->nocase[p]);
+
+    reserveRules(dst, src->rule_count);
+    for (int r = 0; r < src->rule_count; r++) {
+        SnortRule rule = src->rules[r];
+        rule.first_content += content_base;
+        rule.pattern_id = (uint32_t)remap[rule.pattern_id];
+        dst->rules[dst->rule_count++] = rule;
+    }
+    free(remap);
+}
+
+/* -------------------------------------------------------------------------
+ *   Moves the texts of the kept rules to the front of text_pool, in rule
+ *   order, and shrinks the buffer to fit. Comments and rules without a
+ *   usable content are dropped from the resident text.
+ * ------------------------------------------------------------------------- */
+static void compactRuleText(RuleSet *rs) {
+    size_t dst = 0;
+    for (int i = 0; i < rs->rule_count; i++) {
+        SnortRule *rule = &rs->rules[i];
+        const char *src = rs->text_pool + rule->text_offset;
+        size_t size = strlen(src) + 1;
+        // Rules are in file order, so dst never passes the source
+        memmove(rs->text_pool + dst, src, size);
+        rule->text_offset = (uint32_t)dst;
+        dst += size;
+    }
+
+    char *shrunk = realloc(rs->text_pool, dst ? dst : 1);
+    if (shrunk) rs->text_pool = shrunk;
+    rs->text_len = dst;
+}
+
+/* -------------------------------------------------------------------------
+ *   Builds ps's pattern-to-rule map from `count` (pattern, rule) pairs:
+ *   entry i says rule rule_ids[i] has pattern pattern_ids[i] as its fast
+ *   pattern. A counting sort keeps each pattern's rules in input order.
+ * ------------------------------------------------------------------------- */
+void buildPatternRuleMap(PatternSet *ps, const uint32_t *pattern_ids,
+                         const int *rule_ids, int count) {
+    size_t n = (size_t)ps->pattern_count + 1;
+    free(ps->rule_start);
+    free(ps->rule_ids);
+    ps->rule_start = calloc(n, sizeof(uint32_t));
+    ps->rule_ids = malloc((count ? (size_t)count : 1) * sizeof(int));
+    uint32_t *fill = malloc(n * sizeof(uint32_t));
+    if (!ps->rule_start || !ps->rule_ids || !fill) {
+        fprintf(stderr, "Memory allocation failed for pattern rule map.\n");
         exit(EXIT_FAILURE);
     }
 
-    int currPattern = 0;
-    char line[1024];
+    for (int i = 0; i < count; i++)
+        ps->rule_start[pattern_ids[i] + 1]++;
+    for (int p = 0; p < ps->pattern_count; p++)
+        ps->rule_start[p + 1] += ps->rule_start[p];
 
-    while (fgets(line, sizeof(line), fp)) {
-        trim(line);
-        if (line[0] == '#' || strlen(line) < 5)
-            continue;   // We don't care for comments or empty lines
+    memcpy(fill, ps->rule_start, n * sizeof(uint32_t));
+    for (int i = 0; i < count; i++)
+        ps->rule_ids[fill[pattern_ids[i]]++] = rule_ids[i];
+    free(fill);
+}
 
-        addContentToTable(line, ps, &currPattern);
+/* -------------------------------------------------------------------------
+ *   Completes a RuleSet once every rule has been added: compacts the rule
+ *   text, builds the pattern-to-rule map and drops the intern table.
+ * ------------------------------------------------------------------------- */
+void finalizeRuleSet(RuleSet *rs) {
+    compactRuleText(rs);
+
+    size_t n = rs->rule_count ? (size_t)rs->rule_count : 1;
+    uint32_t *pattern_ids = malloc(n * sizeof(uint32_t));
+    int *rule_ids = malloc(n * sizeof(int));
+    if (!pattern_ids || !rule_ids) {
+        fprintf(stderr, "Memory allocation failed for pattern rule map.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int r = 0; r < rs->rule_count; r++) {
+        pattern_ids[r] = rs->rules[r].pattern_id;
+        rule_ids[r] = r;
+    }
+    buildPatternRuleMap(rs->ps, pattern_ids, rule_ids, rs->rule_count);
+    free(pattern_ids);
+    free(rule_ids);
+
+    free(rs->intern);
+    rs->intern = NULL;
+    rs->intern_cap = 0;
+}
+
+/* -------------------------------------------------------------------------
+ *   Loads and parses all Snort rules from a specified ruleset file. The
+ *   file is read into a single buffer that becomes the rule text pool;
+ *   lines are terminated and trimmed in place, so no rule is copied.
+ *   Every rule with at least one positive content is kept in the
+ *   returned RuleSet, and its fast pattern is stored in the Wu–Manber
+ *   PatternSet.
+ * ------------------------------------------------------------------------- */
+RuleSet *loadSnortRulesFromFile(const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        perror(filename);
+        return NULL;
     }
 
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    if (size < 0 || (unsigned long)size >= UINT32_MAX) {
+        fprintf(stderr, "Ruleset file %s is unreadable or too large.\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+
+    char *text = malloc((size_t)size + 1);
+    if (!text) {
+        fprintf(stderr, "Memory allocation failed for ruleset buffer.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t text_len = fread(text, 1, (size_t)size, fp);
     fclose(fp);
-    ps->pattern_count = currPattern;
-    return ps;
+    text[text_len] = '\0';
+
+    RuleSet *rs = calloc(1, sizeof(RuleSet));
+    if (!rs) {
+        fprintf(stderr, "Memory allocation failed for RuleSet.\n");
+        exit(EXIT_FAILURE);
+    }
+    rs->ps = createPatternSet();
+    rs->text_pool = text;
+    rs->text_len = text_len;
+
+    parseRuleLines(rs, 0, text_len);
+    finalizeRuleSet(rs);
+    return rs;
+}
+
+/* -------------------------------------------------------------------------
+ *   Releases a RuleSet, its rules and the PatternSet it owns. Sets loaded
+ *   from a cache only own their headers and the mapping.
+ * ------------------------------------------------------------------------- */
+void freeRuleSet(RuleSet *rs) {
+    if (!rs) return;
+    if (rs->mapping) {
+        munmap(rs->mapping, rs->mapping_len);
+        free(rs->ps);
+        free(rs);
+        return;
+    }
+    free(rs->rules);
+    free(rs->contents);
+    free(rs->text_pool);
+    free(rs->intern);
+    freePatternSet(rs->ps);
+    free(rs);
 }
 
 /* -------------------------------------------------------------------------
@@ -112,16 +808,3 @@ WuManberTables *createTable(PatternSet *ps, int use_bloom) {
 
     return tbl;
 }
-
-/**
- * TODO: a function which accepts an incoming packet, processes it
- * before string matching and finally, snort rules are verified against it
- * packet with the below options I found relevant, need to check if we should
- * consider these.
- * fast_pattern
- * nocase
- * width
- * endian
- *
- * Ask Maggie whether she still wants to do this.
- */
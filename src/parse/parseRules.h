@@ -3,11 +3,133 @@
 
 #include "../algorithms/WM/wm.h"
 
+/* ---------------------------------------------------------------
+ * ContentModifiers:
+ *   Options attached to a single content match in a rule.
+ *   offset/depth bound the match from the start of the buffer;
+ *   distance/within bound it from the end of the previous match
+ *   and set `relative`. A depth or within of 0 means unbounded.
+ * --------------------------------------------------------------- */
+typedef struct {
+    int nocase;
+    int fast_pattern;
+    int negated;
+    int relative;
+    int offset;
+    int depth;
+    int distance;
+    int within;
+} ContentModifiers;
+
+/* ---------------------------------------------------------------
+ * RuleContent:
+ *   One content match of a rule. The decoded bytes live in the
+ *   owning PatternSet pool at [offset, offset + length).
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint32_t         offset;
+    int              length;
+    ContentModifiers mods;
+} RuleContent;
+
+/* ---------------------------------------------------------------
+ * SnortRule:
+ *   One entry of the rule table. The rule text starts at
+ *   text_offset in RuleSet.text_pool; its header (action, protocol,
+ *   addresses and ports), option list and msg string are given as
+ *   offsets relative to that start, so nothing is copied out of
+ *   the text. A rule with no msg has msg_len 0.
+ *
+ *   Its contents are the content_count entries of RuleSet.contents
+ *   starting at first_content; the one at index fast_pattern
+ *   (relative to first_content) is the single literal fed to the
+ *   multi-pattern engines, the rest are only evaluated once that
+ *   literal has been found. pattern_id is that literal's interned
+ *   PatternSet index. The rule holds no pointers, so the table can
+ *   be written to and mapped from a cache file.
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint32_t sid;
+    uint32_t rev;
+    uint32_t text_offset;
+    uint32_t header_len;
+    uint32_t options_offset;
+    uint32_t options_len;
+    uint32_t msg_offset;
+    uint32_t msg_len;
+    uint32_t first_content;
+    uint32_t pattern_id;
+    int      content_count;
+    int      fast_pattern;
+} SnortRule;
+
+/* ---------------------------------------------------------------
+ * RuleSet:
+ *   All loaded rules plus the PatternSet holding their content
+ *   bytes; ps->rule_start/rule_ids map each prefilter pattern to
+ *   the rules that share it. While rules are being added, `intern`
+ *   is an open-addressing table (pattern index + 1, 0 = empty) used
+ *   to find an existing identical pattern; finalizeRuleSet builds
+ *   the pattern-to-rule map and releases it.
+ *   text_pool is the rules file itself, read into one buffer and
+ *   compacted in place down to the NUL-terminated texts of the
+ *   kept rules. When loaded from a cache, every array points into
+ *   `mapping`.
+ * --------------------------------------------------------------- */
+typedef struct {
+    PatternSet  *ps;
+    SnortRule   *rules;
+    int          rule_count;
+    int          rule_cap;
+    RuleContent *contents;
+    int          content_count;
+    int          content_cap;
+    char        *text_pool;
+    size_t       text_len;
+    int         *intern;
+    size_t       intern_cap;
+    void        *mapping;
+    size_t       mapping_len;
+} RuleSet;
+
+/* ---------------------------------------------------------------
+ *      Accessors for a rule's contents, text, header and msg
+ * --------------------------------------------------------------- */
+static inline const RuleContent *ruleContents(const RuleSet *rs, const SnortRule *rule) {
+    return rs->contents + rule->first_content;
+}
+
+static inline const char *ruleText(const RuleSet *rs, const SnortRule *rule) {
+    return rs->text_pool + rule->text_offset;
+}
+
+static inline const char *ruleHeader(const RuleSet *rs, const SnortRule *rule) {
+    return ruleText(rs, rule);
+}
+
+static inline const char *ruleOptions(const RuleSet *rs, const SnortRule *rule) {
+    return ruleText(rs, rule) + rule->options_offset;
+}
+
+static inline const char *ruleMsg(const RuleSet *rs, const SnortRule *rule) {
+    return ruleText(rs, rule) + rule->msg_offset;
+}
+
 /* ---------------------------------------------------------------
  *                        Parsing API
  * --------------------------------------------------------------- */
-PatternSet *addContentToTable(char *snortRule, PatternSet *ps, int *currPattern);
-PatternSet *loadSnortRulesFromFile(const char *filename);
+PatternSet *createPatternSet(void);
+void freePatternSet(PatternSet *ps);
+int addPatternToSet(PatternSet *ps, const unsigned char *bytes, int len, int nocase);
+void buildPatternRuleMap(PatternSet *ps, const uint32_t *pattern_ids,
+                         const int *rule_ids, int count);
+int decodeContent(const char *src, size_t src_len, unsigned char *out, size_t out_cap);
+int addRuleToSet(RuleSet *rs, uint32_t text_offset);
+int parseRuleLines(RuleSet *rs, size_t begin, size_t end);
+void mergeRuleSet(RuleSet *dst, const RuleSet *src);
+void finalizeRuleSet(RuleSet *rs);
+RuleSet *loadSnortRulesFromFile(const char *filename);
+void freeRuleSet(RuleSet *rs);
 WuManberTables *createTable(PatternSet *ps, int use_bloom);
 
 #endif  // SRC_PARSE_PARSERULES_H_
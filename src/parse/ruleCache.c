@@ -0,0 +1,248 @@
+/*
+ *                 Precompiled Binary Ruleset Cache
+ *
+ * ---------------------------------------------------------------
+ * Serializes a parsed RuleSet (pattern pool and index, rule table,
+ * rule contents and rule texts) into a single versioned and
+ * checksummed file. On later runs the file is mmap'ed and the
+ * RuleSet arrays point straight into the mapping, so startup
+ * skips text parsing entirely.
+ *
+ * Layout:
+ *   RuleCacheHeader | pool | offsets | lens | nocase | rule_start |
+ *   rule_ids | rules | contents | text   (each section 8-byte aligned)
+ *
+ * A cache is rejected, and the rules re-parsed, whenever the
+ * magic, version, byte order, struct sizes, source stamp (total
+ * size and a hash of each file's path, size, mtime and inode), or
+ * payload checksum do not match.
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ruleCache.h"
+#include "loadRules.h"
+
+#define CACHE_ALIGN       8u
+#define CACHE_BYTE_ORDER  0x01020304u
+
+/* ---------------------------------------------------------------
+ *   Round n up to the section alignment
+ * --------------------------------------------------------------- */
+static uint64_t alignUp(uint64_t n) {
+    return (n + CACHE_ALIGN - 1) & ~(uint64_t)(CACHE_ALIGN - 1);
+}
+
+/* ---------------------------------------------------------------
+ *        64-bit FNV-1a checksum over the cache payload
+ * --------------------------------------------------------------- */
+static uint64_t checksum64(const unsigned char *p, size_t n) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+/* ---------------------------------------------------------------
+ *   Copy one section into the image and record its offset
+ * --------------------------------------------------------------- */
+static void putSection(unsigned char *img, uint64_t *cursor, uint64_t *off,
+                       const void *src, size_t n) {
+    *off = *cursor;
+    if (n) memcpy(img + *cursor, src, n);
+    *cursor = alignUp(*cursor + n);
+}
+
+/* ---------------------------------------------------------------
+ *   Write rs to cache_path, tagged with the stamp of the rules
+ *   file or directory it was parsed from, taken before it was
+ *   read. The file is written to a temporary name and renamed, so
+ *   readers never see a partial cache. Returns 0 on success, -1 on
+ *   failure.
+ * --------------------------------------------------------------- */
+int saveRuleCache(const RuleSet *rs, const char *cache_path,
+                  const RuleSourceStamp *source) {
+    const PatternSet *ps = rs->ps;
+    size_t np = (size_t)ps->pattern_count;
+
+    uint64_t total = alignUp(sizeof(RuleCacheHeader));
+    total += alignUp(ps->pool_len);
+    total += alignUp(np * sizeof(uint32_t));
+    total += alignUp(np * sizeof(int));
+    total += alignUp(np * sizeof(uint8_t));
+    total += alignUp((np + 1) * sizeof(uint32_t));
+    total += alignUp((size_t)rs->rule_count * sizeof(int));
+    total += alignUp((size_t)rs->rule_count * sizeof(SnortRule));
+    total += alignUp((size_t)rs->content_count * sizeof(RuleContent));
+    total += alignUp(rs->text_len);
+
+    unsigned char *img = calloc(1, (size_t)total);
+    if (!img) return -1;
+
+    RuleCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, RULE_CACHE_MAGIC, sizeof(h.magic));
+    h.version = RULE_CACHE_VERSION;
+    h.byte_order = CACHE_BYTE_ORDER;
+    h.rule_size = (uint32_t)sizeof(SnortRule);
+    h.content_size = (uint32_t)sizeof(RuleContent);
+    h.source_size = source->size;
+    h.source_hash = source->hash;
+    h.pattern_count = (uint32_t)ps->pattern_count;
+    h.rule_count = (uint32_t)rs->rule_count;
+    h.content_count = (uint32_t)rs->content_count;
+    h.pool_len = ps->pool_len;
+    h.text_len = rs->text_len;
+
+    uint64_t cursor = alignUp(sizeof(RuleCacheHeader));
+    putSection(img, &cursor, &h.off_pool, ps->pool, ps->pool_len);
+    putSection(img, &cursor, &h.off_offsets, ps->offsets, np * sizeof(uint32_t));
+    putSection(img, &cursor, &h.off_lens, ps->pattern_lens, np * sizeof(int));
+    putSection(img, &cursor, &h.off_nocase, ps->nocase, np * sizeof(uint8_t));
+    putSection(img, &cursor, &h.off_rule_start, ps->rule_start, (np + 1) * sizeof(uint32_t));
+    putSection(img, &cursor, &h.off_rule_ids, ps->rule_ids,
+               (size_t)rs->rule_count * sizeof(int));
+    putSection(img, &cursor, &h.off_rules, rs->rules,
+               (size_t)rs->rule_count * sizeof(SnortRule));
+    putSection(img, &cursor, &h.off_contents, rs->contents,
+               (size_t)rs->content_count * sizeof(RuleContent));
+    putSection(img, &cursor, &h.off_text, rs->text_pool, rs->text_len);
+
+    size_t payload_off = (size_t)alignUp(sizeof(RuleCacheHeader));
+    h.payload_size = total - payload_off;
+    h.checksum = checksum64(img + payload_off, (size_t)h.payload_size);
+    memcpy(img, &h, sizeof(h));
+
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        free(img);
+        return -1;
+    }
+    size_t written = fwrite(img, 1, (size_t)total, fp);
+    int closed = fclose(fp);
+    free(img);
+
+    if (written != (size_t)total || closed != 0 || rename(tmp_path, cache_path) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Check that a section lies inside the mapping
+ * --------------------------------------------------------------- */
+static int sectionOk(uint64_t off, uint64_t n, size_t map_len) {
+    return off <= map_len && n <= map_len - off;
+}
+
+/* ---------------------------------------------------------------
+ *   Map cache_path and return a RuleSet whose arrays point into
+ *   the mapping, or NULL if the cache is missing, was not written
+ *   for the source stamp, or fails validation.
+ * --------------------------------------------------------------- */
+RuleSet *loadRuleCache(const char *cache_path, const RuleSourceStamp *source) {
+    struct stat st;
+    int fd = open(cache_path, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(RuleCacheHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t map_len = (size_t)st.st_size;
+    unsigned char *map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    RuleCacheHeader h;
+    memcpy(&h, map, sizeof(h));
+
+    size_t payload_off = (size_t)alignUp(sizeof(RuleCacheHeader));
+    uint64_t np = h.pattern_count;
+    int valid =
+        memcmp(h.magic, RULE_CACHE_MAGIC, sizeof(h.magic)) == 0 &&
+        h.version == RULE_CACHE_VERSION &&
+        h.byte_order == CACHE_BYTE_ORDER &&
+        h.rule_size == sizeof(SnortRule) &&
+        h.content_size == sizeof(RuleContent) &&
+        h.source_size == source->size &&
+        h.source_hash == source->hash &&
+        h.payload_size == map_len - payload_off &&
+        sectionOk(h.off_pool, h.pool_len, map_len) &&
+        sectionOk(h.off_offsets, np * sizeof(uint32_t), map_len) &&
+        sectionOk(h.off_lens, np * sizeof(int), map_len) &&
+        sectionOk(h.off_nocase, np * sizeof(uint8_t), map_len) &&
+        sectionOk(h.off_rule_start, (np + 1) * sizeof(uint32_t), map_len) &&
+        sectionOk(h.off_rule_ids, (uint64_t)h.rule_count * sizeof(int), map_len) &&
+        sectionOk(h.off_rules, (uint64_t)h.rule_count * sizeof(SnortRule), map_len) &&
+        sectionOk(h.off_contents, (uint64_t)h.content_count * sizeof(RuleContent), map_len) &&
+        sectionOk(h.off_text, h.text_len, map_len) &&
+        checksum64(map + payload_off, (size_t)h.payload_size) == h.checksum;
+
+    if (!valid) {
+        munmap(map, map_len);
+        return NULL;
+    }
+
+    RuleSet *rs = calloc(1, sizeof(RuleSet));
+    PatternSet *ps = calloc(1, sizeof(PatternSet));
+    if (!rs || !ps) {
+        fprintf(stderr, "Memory allocation failed for cached RuleSet.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Arrays are read-only views into the mapping; the *_cap fields
+    // stay 0 because a mapped set is never grown
+    ps->pool = map + h.off_pool;
+    ps->pool_len = (size_t)h.pool_len;
+    ps->offsets = (uint32_t *)(void *)(map + h.off_offsets);
+    ps->pattern_lens = (int *)(void *)(map + h.off_lens);
+    ps->nocase = map + h.off_nocase;
+    ps->rule_start = (uint32_t *)(void *)(map + h.off_rule_start);
+    ps->rule_ids = (int *)(void *)(map + h.off_rule_ids);
+    ps->pattern_count = (int)h.pattern_count;
+
+    rs->ps = ps;
+    rs->rules = (SnortRule *)(void *)(map + h.off_rules);
+    rs->rule_count = (int)h.rule_count;
+    rs->contents = (RuleContent *)(void *)(map + h.off_contents);
+    rs->content_count = (int)h.content_count;
+    rs->text_pool = (char *)(map + h.off_text);
+    rs->text_len = (size_t)h.text_len;
+    rs->mapping = map;
+    rs->mapping_len = map_len;
+    return rs;
+}
+
+/* ---------------------------------------------------------------
+ *   Load rules from cache_path if it is valid for rules_path;
+ *   otherwise parse rules_path and refresh the cache. The stamp is
+ *   taken before the rules are read, so a file edited during the
+ *   parse leaves a cache that no longer matches it rather than one
+ *   that hides the edit.
+ * --------------------------------------------------------------- */
+RuleSet *loadRulesWithCache(const char *rules_path, const char *cache_path) {
+    RuleSourceStamp source;
+    if (ruleSourceStamp(rules_path, &source) != 0)
+        return loadSnortRules(rules_path, 0);
+
+    RuleSet *rs = loadRuleCache(cache_path, &source);
+    if (rs) {
+        printf("[*] Loaded compiled ruleset from cache: %s\n", cache_path);
+        return rs;
+    }
+
+    rs = loadSnortRules(rules_path, 0);
+    if (rs && saveRuleCache(rs, cache_path, &source) != 0)
+        fprintf(stderr, "[!] Could not write ruleset cache %s\n", cache_path);
+    return rs;
+}
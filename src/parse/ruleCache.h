@@ -0,0 +1,59 @@
+#ifndef SRC_PARSE_RULECACHE_H_
+#define SRC_PARSE_RULECACHE_H_
+
+#include <stdint.h>
+
+#include "parseRules.h"
+#include "loadRules.h"
+
+#define RULE_CACHE_MAGIC    "NIDSRULE"
+#define RULE_CACHE_VERSION  5u
+
+/* ---------------------------------------------------------------
+ * RuleCacheHeader:
+ *   Fixed header at the start of a compiled ruleset cache. The
+ *   cache is only valid for the exact rules source (size and
+ *   file identity hash) and struct layout it was written from, and its payload must
+ *   match the stored FNV-1a checksum. Section offsets are from the
+ *   start of the file and 8-byte aligned so arrays can be used in
+ *   place from an mmap'ed view.
+ * --------------------------------------------------------------- */
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t rule_size;
+    uint32_t content_size;
+
+    uint64_t source_size;
+    uint64_t source_hash;
+    uint64_t payload_size;
+    uint64_t checksum;
+
+    uint32_t pattern_count;
+    uint32_t rule_count;
+    uint32_t content_count;
+    uint32_t reserved;
+    uint64_t pool_len;
+    uint64_t text_len;
+
+    uint64_t off_pool;
+    uint64_t off_offsets;
+    uint64_t off_lens;
+    uint64_t off_nocase;
+    uint64_t off_rule_start;
+    uint64_t off_rule_ids;
+    uint64_t off_rules;
+    uint64_t off_contents;
+    uint64_t off_text;
+} RuleCacheHeader;
+
+/* ---------------------------------------------------------------
+ *                     Ruleset Cache API
+ * --------------------------------------------------------------- */
+int      saveRuleCache(const RuleSet *rs, const char *cache_path,
+                       const RuleSourceStamp *source);
+RuleSet *loadRuleCache(const char *cache_path, const RuleSourceStamp *source);
+RuleSet *loadRulesWithCache(const char *rules_path, const char *cache_path);
+
+#endif  // SRC_PARSE_RULECACHE_H_
@@ -0,0 +1,631 @@
+/*
+ *                 Protocol / Port Rule Groups
+ *
+ * ---------------------------------------------------------------
+ * Splits a RuleSet into groups by the protocol and ports in each
+ * rule header and compiles one matcher per group, so a packet is
+ * only scanned against the fast patterns of rules that can apply
+ * to its 5-tuple. Each group gets its own PatternSet (copied out
+ * of the rule set) whose rule map points back at global rule
+ * indices, so verdicts and evaluation are shared across groups.
+ *
+ * Port variables are resolved against Snort 3's defaults
+ * (snort_defaults.lua); unknown variables, negated specs and
+ * very large port sets are treated as "any".
+ *
+ * Reference:
+ *   Snort rule headers:
+ *     https://docs.snort.org/rules/headers/
+ *   Snort fast pattern port groups:
+ *     https://docs.snort.org/start/snort2_snort3
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "ruleGroups.h"
+
+#define PORT_COUNT            65536
+#define PORT_WORDS            (PORT_COUNT / 64)
+#define PORT_GROUP_MAX_PORTS  1024    // larger sets go to the any-port group
+#define PORT_VAR_MAX_DEPTH    8
+
+#define IP_PROTO_TCP  6
+#define IP_PROTO_UDP  17
+
+#define RULE_PROTO_IP     0
+#define RULE_PROTO_TCP    1
+#define RULE_PROTO_UDP    2
+#define RULE_PROTO_OTHER  3
+
+typedef struct {
+    uint64_t bits[PORT_WORDS];
+} PortSet;
+
+/* ---------------------------------------------------------------
+ *           Port variables from Snort 3 snort_defaults.lua
+ * --------------------------------------------------------------- */
+#define DEFAULT_HTTP_PORTS \
+    "80,81,311,383,591,593,901,1220,1414,1741,1830,2301,2381,2809,3037," \
+    "3128,3702,4343,4848,5250,6988,7000,7001,7144,7145,7510,7777,7779," \
+    "8000,8008,8014,8028,8080,8085,8088,8090,8118,8123,8180,8181,8243," \
+    "8280,8300,8800,8888,8899,9000,9060,9080,9090,9091,9443,9999,11371," \
+    "34443,34444,41080,50002,55555"
+
+static const struct {
+    const char *name;
+    const char *spec;
+} port_vars[] = {
+    { "HTTP_PORTS",      "[" DEFAULT_HTTP_PORTS "]" },
+    { "FILE_DATA_PORTS", "[" DEFAULT_HTTP_PORTS ",110,143]" },
+    { "FTP_PORTS",       "[21,2100,3535]" },
+    { "SIP_PORTS",       "[5060,5061,5600]" },
+    { "SSH_PORTS",       "22" },
+    { "ORACLE_PORTS",    "1024:" },
+    { "SHELLCODE_PORTS", "!80" },
+};
+
+/* ---------------------------------------------------------------
+ *                     PortSet bit helpers
+ * --------------------------------------------------------------- */
+static void portSetFill(PortSet *p, int value) {
+    memset(p->bits, value ? 0xff : 0, sizeof(p->bits));
+}
+
+static void portSetRange(PortSet *p, unsigned lo, unsigned hi) {
+    for (unsigned port = lo; port <= hi; port++)
+        p->bits[port >> 6] |= 1ULL << (port & 63);
+}
+
+static int portSetHas(const PortSet *p, unsigned port) {
+    return (int)((p->bits[port >> 6] >> (port & 63)) & 1);
+}
+
+static int portSetCount(const PortSet *p) {
+    int n = 0;
+    for (int i = 0; i < PORT_WORDS; i++)
+        n += __builtin_popcountll(p->bits[i]);
+    return n;
+}
+
+/* ---------------------------------------------------------------
+ *   Parse a port number, stopping at `end`. Returns -1 if there
+ *   is no number or it is out of range.
+ * --------------------------------------------------------------- */
+static long parsePort(const char **p, const char *end) {
+    const char *s = *p;
+    long v = 0;
+    if (s >= end || !isdigit((unsigned char)*s)) return -1;
+    while (s < end && isdigit((unsigned char)*s)) {
+        v = v * 10 + (*s - '0');
+        if (v >= PORT_COUNT) return -1;
+        s++;
+    }
+    *p = s;
+    return v;
+}
+
+/* ---------------------------------------------------------------
+ *   Allocate an empty PortSet for negated specs
+ * --------------------------------------------------------------- */
+static PortSet *newPortSet(void) {
+    PortSet *p = calloc(1, sizeof(PortSet));
+    if (!p) {
+        fprintf(stderr, "Memory allocation failed for port set.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* ---------------------------------------------------------------
+ *   Parse a Snort port spec ("any", "80", "1024:", "!22",
+ *   "[80,443,$HTTP_PORTS]") in [spec, end) and add its ports to
+ *   out. Returns 0 on success, -1 if the spec is not understood.
+ * --------------------------------------------------------------- */
+static int parsePortSpec(const char *spec, const char *end, PortSet *out, int depth) {
+    while (spec < end && isspace((unsigned char)*spec)) spec++;
+    while (end > spec && isspace((unsigned char)end[-1])) end--;
+    if (spec == end || depth > PORT_VAR_MAX_DEPTH) return -1;
+
+    size_t len = (size_t)(end - spec);
+    if (len == 3 && strncmp(spec, "any", 3) == 0) {
+        portSetFill(out, 1);
+        return 0;
+    }
+
+    if (*spec == '!') {
+        PortSet *tmp = newPortSet();
+        int rc = parsePortSpec(spec + 1, end, tmp, depth + 1);
+        if (rc == 0) {
+            for (int i = 0; i < PORT_WORDS; i++) out->bits[i] |= ~tmp->bits[i];
+        }
+        free(tmp);
+        return rc;
+    }
+
+    if (*spec == '$') {
+        for (size_t i = 0; i < sizeof(port_vars) / sizeof(port_vars[0]); i++) {
+            if (strlen(port_vars[i].name) == len - 1 &&
+                strncmp(port_vars[i].name, spec + 1, len - 1) == 0) {
+                const char *v = port_vars[i].spec;
+                return parsePortSpec(v, v + strlen(v), out, depth + 1);
+            }
+        }
+        return -1;
+    }
+
+    if (*spec == '[') {
+        if (end[-1] != ']') return -1;
+        const char *list_end = end - 1;
+
+        // Lists with exclusions are built apart so that "[a,!b]"
+        // only removes b from this list, not from ports already in out
+        int has_neg = memchr(spec, '!', len) != NULL;
+        PortSet *pos = has_neg ? newPortSet() : out;
+        PortSet *neg = has_neg ? newPortSet() : NULL;
+        int positives = 0, rc = 0;
+
+        const char *p = spec + 1;
+        while (p < list_end && rc == 0) {
+            // Split on commas outside nested brackets
+            const char *q = p;
+            int nest = 0;
+            while (q < list_end && (nest > 0 || *q != ',')) {
+                if (*q == '[') nest++;
+                if (*q == ']') nest--;
+                q++;
+            }
+            while (p < q && isspace((unsigned char)*p)) p++;
+            int negated = (p < q && *p == '!');
+            rc = parsePortSpec(p + negated, q, negated ? neg : pos, depth + 1);
+            positives += !negated;
+            p = q + 1;
+        }
+
+        if (has_neg) {
+            if (rc == 0) {
+                if (!positives) portSetFill(pos, 1);
+                for (int i = 0; i < PORT_WORDS; i++)
+                    out->bits[i] |= pos->bits[i] & ~neg->bits[i];
+            }
+            free(pos);
+            free(neg);
+        }
+        return rc;
+    }
+
+    // Single port or range: "a", "a:b", "a:", ":b"
+    const char *p = spec;
+    long lo = 0, hi = PORT_COUNT - 1;
+    if (*p != ':') {
+        lo = parsePort(&p, end);
+        if (lo < 0) return -1;
+        hi = lo;
+    }
+    if (p < end && *p == ':') {
+        p++;
+        hi = (p < end) ? parsePort(&p, end) : PORT_COUNT - 1;
+        if (hi < 0) return -1;
+    }
+    if (p != end || lo > hi) return -1;
+
+    portSetRange(out, (unsigned)lo, (unsigned)hi);
+    return 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Parse a port spec and report whether it is specific enough to
+ *   be grouped on. Returns 1 if out holds a usable port set.
+ * --------------------------------------------------------------- */
+static int specificPorts(const char *spec, const char *end, PortSet *out) {
+    portSetFill(out, 0);
+    if (parsePortSpec(spec, end, out, 0) != 0) return 0;
+    int n = portSetCount(out);
+    return n > 0 && n <= PORT_GROUP_MAX_PORTS;
+}
+
+/* ---------------------------------------------------------------
+ *   Split a rule header into whitespace-separated fields, keeping
+ *   bracketed lists together. Returns the number of fields found.
+ * --------------------------------------------------------------- */
+static int splitHeader(const char *hdr, size_t len, const char *start[7], const char *stop[7]) {
+    const char *p = hdr, *end = hdr + len;
+    int n = 0;
+    while (n < 7) {
+        while (p < end && isspace((unsigned char)*p)) p++;
+        if (p == end) break;
+        start[n] = p;
+        int nest = 0;
+        while (p < end && (nest > 0 || !isspace((unsigned char)*p))) {
+            if (*p == '[') nest++;
+            if (*p == ']') nest--;
+            p++;
+        }
+        stop[n++] = p;
+    }
+    return n;
+}
+
+/* ---------------------------------------------------------------
+ *   Map a header protocol field to RULE_PROTO_*. Snort 3 service
+ *   rules ("alert http (...)") run over TCP.
+ * --------------------------------------------------------------- */
+static int ruleProto(const char *s, size_t len) {
+    if (len == 3 && strncmp(s, "tcp", 3) == 0) return RULE_PROTO_TCP;
+    if (len == 3 && strncmp(s, "udp", 3) == 0) return RULE_PROTO_UDP;
+    if (len == 4 && strncmp(s, "icmp", 4) == 0) return RULE_PROTO_OTHER;
+    if (len == 2 && strncmp(s, "ip", 2) == 0) return RULE_PROTO_IP;
+    if (len == 4 && strncmp(s, "http", 4) == 0) return RULE_PROTO_TCP;
+    return RULE_PROTO_IP;
+}
+
+/* ---------------------------------------------------------------
+ *   Growable list of rule indices
+ * --------------------------------------------------------------- */
+typedef struct {
+    int *ids;
+    int  count;
+    int  cap;
+} RuleList;
+
+static void ruleListPush(RuleList *l, int id) {
+    if (l->count == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 64;
+        l->ids = realloc(l->ids, (size_t)l->cap * sizeof(int));
+        if (!l->ids) {
+            fprintf(stderr, "Memory allocation failed for rule list.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    l->ids[l->count++] = id;
+}
+
+/* ---------------------------------------------------------------
+ *   (port map, port, rule) triple packed for sorting
+ * --------------------------------------------------------------- */
+static uint64_t portKey(int map, unsigned port, int rule_id) {
+    return ((uint64_t)map << 48) | ((uint64_t)port << 32) | (uint32_t)rule_id;
+}
+
+static int compareKeys(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* ---------------------------------------------------------------
+ *   Add each port in ports to the given map for rule_id
+ * --------------------------------------------------------------- */
+static void addPortKeys(const PortSet *ports, int map, int rule_id, uint64_t **keys,
+                        size_t *count, size_t *cap) {
+    for (unsigned port = 0; port < PORT_COUNT; port++) {
+        if (!ports->bits[port >> 6]) {
+            port |= 63;     // skip an empty word
+            continue;
+        }
+        if (!portSetHas(ports, port)) continue;
+        if (*count == *cap) {
+            *cap = *cap ? *cap * 2 : 4096;
+            *keys = realloc(*keys, *cap * sizeof(uint64_t));
+            if (!*keys) {
+                fprintf(stderr, "Memory allocation failed for port keys.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        (*keys)[(*count)++] = portKey(map, port, rule_id);
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Return the index of the group holding exactly these rules,
+ *   creating it (with no matcher yet) if there is none
+ * --------------------------------------------------------------- */
+static int internGroup(RuleGroupTable *t, int *cap, const int *ids, int count) {
+    for (int g = 0; g < t->group_count; g++) {
+        const RuleGroup *grp = &t->groups[g];
+        if (grp->rule_count == count && grp->rule_ids &&
+            memcmp(grp->rule_ids, ids, (size_t)count * sizeof(int)) == 0)
+            return g;
+    }
+
+    if (t->group_count == *cap) {
+        *cap = *cap ? *cap * 2 : 16;
+        t->groups = realloc(t->groups, (size_t)*cap * sizeof(RuleGroup));
+        if (!t->groups) {
+            fprintf(stderr, "Memory allocation failed for rule groups.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    RuleGroup *grp = &t->groups[t->group_count];
+    memset(grp, 0, sizeof(*grp));
+    grp->rule_ids = malloc((count ? (size_t)count : 1) * sizeof(int));
+    if (!grp->rule_ids) {
+        fprintf(stderr, "Memory allocation failed for rule group.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(grp->rule_ids, ids, (size_t)count * sizeof(int));
+    grp->rule_count = count;
+    return t->group_count++;
+}
+
+/* ---------------------------------------------------------------
+ *   Merge two ascending rule lists into out (no duplicates)
+ * --------------------------------------------------------------- */
+static int mergeRuleIds(const int *a, int na, const int *b, int nb, int *out) {
+    int i = 0, j = 0, n = 0;
+    while (i < na || j < nb) {
+        int v;
+        if (j == nb || (i < na && a[i] < b[j])) v = a[i++];
+        else if (i == na || b[j] < a[i]) v = b[j++];
+        else { v = a[i++]; j++; }
+        out[n++] = v;
+    }
+    return n;
+}
+
+/* ---------------------------------------------------------------
+ *   Build a group's own PatternSet from the fast patterns of its
+ *   rules. local[] maps global pattern ids to group ids and must
+ *   be all -1 on entry; it is restored before returning.
+ * --------------------------------------------------------------- */
+static PatternSet *buildGroupPatterns(const RuleSet *rs, const RuleGroup *grp, int *local) {
+    const PatternSet *all = rs->ps;
+    PatternSet *ps = createPatternSet();
+    uint32_t *pattern_ids = malloc((size_t)grp->rule_count * sizeof(uint32_t));
+    if (!pattern_ids) {
+        fprintf(stderr, "Memory allocation failed for group patterns.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < grp->rule_count; i++) {
+        int gp = (int)rs->rules[grp->rule_ids[i]].pattern_id;
+        if (local[gp] < 0)
+            local[gp] = addPatternToSet(ps, ps_pattern(all, gp), all->pattern_lens[gp],
+                                        all->nocase[gp]);
+        pattern_ids[i] = (uint32_t)local[gp];
+    }
+    buildPatternRuleMap(ps, pattern_ids, grp->rule_ids, grp->rule_count);
+
+    for (int i = 0; i < grp->rule_count; i++)
+        local[rs->rules[grp->rule_ids[i]].pattern_id] = -1;
+    free(pattern_ids);
+    return ps;
+}
+
+/* ---------------------------------------------------------------
+ *   Partition rs into protocol/port groups and compile a matcher
+ *   of type alg for each
+ * --------------------------------------------------------------- */
+RuleGroupTable *buildRuleGroups(const RuleSet *rs, AlgorithmType alg) {
+    RuleGroupTable *t = calloc(1, sizeof(RuleGroupTable));
+    PortSet *src = malloc(sizeof(PortSet));
+    PortSet *dst = malloc(sizeof(PortSet));
+    if (!t || !src || !dst) {
+        fprintf(stderr, "Memory allocation failed for RuleGroupTable.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int m = 0; m < PORT_MAP_COUNT; m++) {
+        t->port_map[m] = calloc(PORT_COUNT, sizeof(uint16_t));
+        if (!t->port_map[m]) {
+            fprintf(stderr, "Memory allocation failed for port map.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    RuleList any[GROUP_PROTO_COUNT] = {{0}};
+    uint64_t *keys = NULL;
+    size_t key_count = 0, key_cap = 0;
+
+    // Classify every rule by its header
+    for (int r = 0; r < rs->rule_count; r++) {
+        const SnortRule *rule = &rs->rules[r];
+        const char *f[7], *e[7];
+        int nf = splitHeader(ruleHeader(rs, rule), rule->header_len, f, e);
+        int proto = nf >= 2 ? ruleProto(f[1], (size_t)(e[1] - f[1])) : RULE_PROTO_IP;
+
+        if (proto == RULE_PROTO_IP) {
+            for (int p = 0; p < GROUP_PROTO_COUNT; p++) ruleListPush(&any[p], r);
+            continue;
+        }
+        if (proto == RULE_PROTO_OTHER) {
+            ruleListPush(&any[GROUP_PROTO_OTHER], r);
+            continue;
+        }
+
+        int slot = (proto == RULE_PROTO_TCP) ? GROUP_PROTO_TCP : GROUP_PROTO_UDP;
+        int src_map = (proto == RULE_PROTO_TCP) ? PORT_MAP_TCP_SRC : PORT_MAP_UDP_SRC;
+        int dst_map = (proto == RULE_PROTO_TCP) ? PORT_MAP_TCP_DST : PORT_MAP_UDP_DST;
+        int unidirectional = nf == 7 && (size_t)(e[4] - f[4]) == 2 && strncmp(f[4], "->", 2) == 0;
+
+        if (unidirectional && specificPorts(f[6], e[6], dst))
+            addPortKeys(dst, dst_map, r, &keys, &key_count, &key_cap);
+        else if (unidirectional && specificPorts(f[3], e[3], src))
+            addPortKeys(src, src_map, r, &keys, &key_count, &key_cap);
+        else
+            ruleListPush(&any[slot], r);
+    }
+    free(src);
+    free(dst);
+
+    int group_cap = 0;
+    for (int p = 0; p < GROUP_PROTO_COUNT; p++)
+        t->any_group[p] = any[p].count ? internGroup(t, &group_cap, any[p].ids, any[p].count) : -1;
+
+    // One group per distinct (port rules + any-port rules) list
+    qsort(keys, key_count, sizeof(uint64_t), compareKeys);
+    int *merged = malloc(((size_t)rs->rule_count + 1) * sizeof(int));
+    RuleList run = {0};
+    if (!merged) {
+        fprintf(stderr, "Memory allocation failed for rule groups.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < key_count;) {
+        uint64_t run_key = keys[i] >> 32;
+        int map = (int)(run_key >> 16);
+        unsigned port = (unsigned)run_key & 0xffff;
+        run.count = 0;
+        for (; i < key_count && (keys[i] >> 32) == run_key; i++)
+            ruleListPush(&run, (int)(uint32_t)keys[i]);
+
+        const RuleList *base = &any[(map <= PORT_MAP_TCP_DST) ? GROUP_PROTO_TCP : GROUP_PROTO_UDP];
+        int n = mergeRuleIds(run.ids, run.count, base->ids, base->count, merged);
+        t->port_map[map][port] = (uint16_t)(internGroup(t, &group_cap, merged, n) + 1);
+    }
+    free(run.ids);
+    free(merged);
+    free(keys);
+    for (int p = 0; p < GROUP_PROTO_COUNT; p++) free(any[p].ids);
+
+    // Compile each group; the all-rules group waits for allRulesGroup
+    int *local = malloc(((size_t)rs->ps->pattern_count + 1) * sizeof(int));
+    if (!local) {
+        fprintf(stderr, "Memory allocation failed for rule groups.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < rs->ps->pattern_count; i++) local[i] = -1;
+    for (int g = 0; g < t->group_count; g++) {
+        RuleGroup *grp = &t->groups[g];
+        grp->ps = buildGroupPatterns(rs, grp, local);
+        grp->owns_ps = 1;
+        grp->matcher = matcher_create(alg, grp->ps);
+    }
+    free(local);
+
+    t->rs = rs;
+    t->alg = alg;
+    t->all = malloc(sizeof(LazyRuleGroup));
+    if (!t->all) {
+        fprintf(stderr, "Memory allocation failed for rule groups.\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_mutex_init(&t->all->lock, NULL);
+    atomic_init(&t->all->group, NULL);
+    return t;
+}
+
+/* ---------------------------------------------------------------
+ *   The group of every rule, reusing the rule set's own patterns.
+ *   Compiled on the first call; later and concurrent callers get
+ *   the same group.
+ * --------------------------------------------------------------- */
+const RuleGroup *allRulesGroup(const RuleGroupTable *t) {
+    LazyRuleGroup *lazy = t->all;
+    RuleGroup *all = atomic_load_explicit(&lazy->group, memory_order_acquire);
+    if (all) return all;
+
+    pthread_mutex_lock(&lazy->lock);
+    all = atomic_load_explicit(&lazy->group, memory_order_relaxed);
+    if (!all) {
+        all = calloc(1, sizeof(RuleGroup));
+        if (!all) {
+            fprintf(stderr, "Memory allocation failed for rule groups.\n");
+            exit(EXIT_FAILURE);
+        }
+        all->ps = t->rs->ps;
+        all->rule_count = t->rs->rule_count;
+        all->matcher = matcher_create(t->alg, t->rs->ps);
+        atomic_store_explicit(&lazy->group, all, memory_order_release);
+    }
+    pthread_mutex_unlock(&lazy->lock);
+    return all;
+}
+
+/* ---------------------------------------------------------------
+ *   Pick the groups to scan for a packet: its destination-port
+ *   and source-port groups, or its protocol's any-port group if
+ *   neither port has one. Returns the number written to out.
+ * --------------------------------------------------------------- */
+int selectRuleGroups(const RuleGroupTable *t, uint8_t ip_proto,
+                     uint16_t src_port, uint16_t dst_port,
+                     const RuleGroup *out[2]) {
+    int slot, n = 0;
+    if (ip_proto == IP_PROTO_TCP || ip_proto == IP_PROTO_UDP) {
+        int tcp = (ip_proto == IP_PROTO_TCP);
+        int dg = t->port_map[tcp ? PORT_MAP_TCP_DST : PORT_MAP_UDP_DST][dst_port];
+        int sg = t->port_map[tcp ? PORT_MAP_TCP_SRC : PORT_MAP_UDP_SRC][src_port];
+        if (dg) out[n++] = &t->groups[dg - 1];
+        if (sg && sg != dg) out[n++] = &t->groups[sg - 1];
+        if (n) return n;
+        slot = tcp ? GROUP_PROTO_TCP : GROUP_PROTO_UDP;
+    } else {
+        slot = GROUP_PROTO_OTHER;
+    }
+
+    if (t->any_group[slot] >= 0) out[n++] = &t->groups[t->any_group[slot]];
+    return n;
+}
+
+/* ---------------------------------------------------------------
+ *   Run group g's matcher over the context's current buffer,
+ *   evaluating rules on every hit
+ * --------------------------------------------------------------- */
+void scanRuleGroup(const RuleGroup *g, RuleMatchContext *ctx) {
+    ctx->ps = g->ps;
+    matcher_scan(g->matcher, ctx->data, ctx->len, &ctx->engine_stats,
+                 onPrefilterHit, ctx);
+}
+
+/* ---------------------------------------------------------------
+ *   As scanRuleGroup, but feed the buffer to the matcher in
+ *   chunk_len pieces through its streaming interface, so the
+ *   engine's working set stays bounded however large the buffer.
+ *   Match ends are stream offsets, i.e. offsets into the buffer,
+ *   so rule evaluation still sees the whole buffer.
+ * --------------------------------------------------------------- */
+void scanRuleGroupChunked(const RuleGroup *g, RuleMatchContext *ctx, size_t chunk_len) {
+    if (chunk_len == 0) chunk_len = ctx->len;
+    ctx->ps = g->ps;
+
+    MatcherStream st;
+    matcher_stream_init(&st, g->matcher);
+    for (size_t off = 0; off < ctx->len; off += chunk_len) {
+        size_t n = ctx->len - off < chunk_len ? ctx->len - off : chunk_len;
+        matcher_stream_feed(&st, ctx->data + off, n, &ctx->engine_stats,
+                            onPrefilterHit, ctx);
+    }
+    matcher_stream_finish(&st);
+}
+
+/* ---------------------------------------------------------------
+ *   Feed the context's current buffer (a segment started with
+ *   beginRuleSegment) to group g's matcher as the next bytes of
+ *   stream st
+ * --------------------------------------------------------------- */
+void feedRuleGroupStream(const RuleGroup *g, MatcherStream *st, RuleMatchContext *ctx) {
+    ctx->ps = g->ps;
+    matcher_stream_feed(st, ctx->data, ctx->len, &ctx->engine_stats,
+                        onPrefilterHit, ctx);
+}
+
+/* ---------------------------------------------------------------
+ *   As feedRuleGroupStream for a resumable matcher: the stream's
+ *   state is passed in and the state after the segment returned
+ * --------------------------------------------------------------- */
+uint32_t resumeRuleGroupScan(const RuleGroup *g, uint32_t state, RuleMatchContext *ctx) {
+    ctx->ps = g->ps;
+    return matcher_scan_from(g->matcher, state, ctx->data, ctx->len, ctx->base,
+                             &ctx->engine_stats, onPrefilterHit, ctx);
+}
+
+/* ---------------------------------------------------------------
+ *        Release every group, its matcher and patterns
+ * --------------------------------------------------------------- */
+void freeRuleGroups(RuleGroupTable *t) {
+    if (!t) return;
+    for (int g = 0; g < t->group_count; g++) {
+        matcher_destroy(t->groups[g].matcher);
+        if (t->groups[g].owns_ps) freePatternSet(t->groups[g].ps);
+        free(t->groups[g].rule_ids);
+    }
+    RuleGroup *all = atomic_load(&t->all->group);
+    if (all) {
+        matcher_destroy(all->matcher);
+        free(all);
+    }
+    pthread_mutex_destroy(&t->all->lock);
+    free(t->all);
+    for (int m = 0; m < PORT_MAP_COUNT; m++) free(t->port_map[m]);
+    free(t->groups);
+    free(t);
+}
@@ -0,0 +1,92 @@
+#ifndef SRC_PARSE_RULEGROUPS_H_
+#define SRC_PARSE_RULEGROUPS_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "parseRules.h"
+#include "evalRules.h"
+#include "../algorithms/matcher.h"
+
+/* ---------------------------------------------------------------
+ *   Port maps of a RuleGroupTable, indexed by protocol/direction
+ * --------------------------------------------------------------- */
+#define PORT_MAP_TCP_SRC  0
+#define PORT_MAP_TCP_DST  1
+#define PORT_MAP_UDP_SRC  2
+#define PORT_MAP_UDP_DST  3
+#define PORT_MAP_COUNT    4
+
+/* ---------------------------------------------------------------
+ *   Protocol slots for the any-port groups
+ * --------------------------------------------------------------- */
+#define GROUP_PROTO_TCP    0
+#define GROUP_PROTO_UDP    1
+#define GROUP_PROTO_OTHER  2
+#define GROUP_PROTO_COUNT  3
+
+/* ---------------------------------------------------------------
+ * RuleGroup:
+ *   A set of rules that are always evaluated together, with its
+ *   own prefilter PatternSet (holding only the fast patterns of
+ *   those rules, mapped back to global rule indices) and its own
+ *   compiled engine. rule_ids is sorted ascending.
+ * --------------------------------------------------------------- */
+typedef struct {
+    PatternSet *ps;
+    Matcher    *matcher;
+    int        *rule_ids;
+    int         rule_count;
+    int         owns_ps;
+} RuleGroup;
+
+/* ---------------------------------------------------------------
+ * RuleGroupTable:
+ *   Rules partitioned by protocol and port, as in Snort's port
+ *   groups. A rule with a specific destination port goes into the
+ *   group of each of its destination ports, else one with a
+ *   specific source port into its source-port groups, else into
+ *   the any-port group of its protocol. Every port group also
+ *   holds its protocol's any-port rules, so a packet only needs
+ *   the group(s) of its own ports. Ports with identical rule lists
+ *   share one group.
+ *
+ *   port_map[map][port] is a group index + 1 (0: no port group).
+ *   any_group[proto] are group indices or -1.
+ *
+ *   The group of every rule, for buffers without a decoded
+ *   5-tuple, is only compiled by the first allRulesGroup call:
+ *   captures never need it. It lives outside `groups`, so
+ *   building it moves no group a scan may be holding.
+ * --------------------------------------------------------------- */
+typedef struct {
+    pthread_mutex_t       lock;
+    _Atomic(RuleGroup *)  group;
+} LazyRuleGroup;
+
+typedef struct {
+    RuleGroup     *groups;
+    int            group_count;
+    uint16_t      *port_map[PORT_MAP_COUNT];
+    int            any_group[GROUP_PROTO_COUNT];
+    const RuleSet *rs;
+    AlgorithmType  alg;
+    LazyRuleGroup *all;
+} RuleGroupTable;
+
+/* ---------------------------------------------------------------
+ *                       Rule Group API
+ * --------------------------------------------------------------- */
+RuleGroupTable *buildRuleGroups(const RuleSet *rs, AlgorithmType alg);
+const RuleGroup *allRulesGroup(const RuleGroupTable *t);
+int selectRuleGroups(const RuleGroupTable *t, uint8_t ip_proto,
+                     uint16_t src_port, uint16_t dst_port,
+                     const RuleGroup *out[2]);
+void scanRuleGroup(const RuleGroup *g, RuleMatchContext *ctx);
+void scanRuleGroupChunked(const RuleGroup *g, RuleMatchContext *ctx, size_t chunk_len);
+void feedRuleGroupStream(const RuleGroup *g, MatcherStream *st, RuleMatchContext *ctx);
+uint32_t resumeRuleGroupScan(const RuleGroup *g, uint32_t state, RuleMatchContext *ctx);
+void freeRuleGroups(RuleGroupTable *t);
+
+#endif  // SRC_PARSE_RULEGROUPS_H_
@@ -0,0 +1,217 @@
+/*
+ *                  Live Ruleset Hot-Reload (RCU)
+ *
+ * ---------------------------------------------------------------
+ * Rebuilds the RuleSet and its per-group matchers on a background
+ * thread and publishes the new engine with a single atomic
+ * pointer swap. Scanning threads never wait: entering and leaving
+ * a read-side section is one atomic store each. The old engine is
+ * reclaimed by the reload thread after a grace period in which
+ * every reader has either left its read-side section or started
+ * a new one (and so already sees the new engine).
+ *
+ * Reference:
+ *   P. E. McKenney, J. D. Slingwine,
+ *   "Read-Copy Update: Using Execution History to Solve
+ *   Concurrency Problems," PDCS 1998.
+ * --------------------------------------------------------------- */
+
+// Define the POSIX source to have access to nanosleep and semaphores
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "ruleReload.h"
+#include "ruleCache.h"
+
+#define RELOAD_POLL_NS  1000000L    // grace-period poll interval (1 ms)
+
+/* ---------------------------------------------------------------
+ *   Load rules (through the cache) and compile their groups.
+ *   Returns NULL if the rules cannot be loaded.
+ * --------------------------------------------------------------- */
+RuleEngine *buildRuleEngine(const char *rules_path, const char *cache_path,
+                            AlgorithmType alg) {
+    RuleSet *rs = loadRulesWithCache(rules_path, cache_path);
+    if (!rs) return NULL;
+
+    RuleEngine *engine = calloc(1, sizeof(RuleEngine));
+    if (!engine) {
+        fprintf(stderr, "Memory allocation failed for RuleEngine.\n");
+        exit(EXIT_FAILURE);
+    }
+    engine->rs = rs;
+    engine->groups = buildRuleGroups(rs, alg);
+    return engine;
+}
+
+/* ---------------------------------------------------------------
+ *           Release an engine that no reader can reach
+ * --------------------------------------------------------------- */
+void freeRuleEngine(RuleEngine *engine) {
+    if (!engine) return;
+    freeRuleGroups(engine->groups);
+    freeRuleSet(engine->rs);
+    free(engine);
+}
+
+/* ---------------------------------------------------------------
+ *   Copy a path string for the reloader to keep
+ * --------------------------------------------------------------- */
+static char *copyPath(const char *path) {
+    size_t n = strlen(path) + 1;
+    char *copy = malloc(n);
+    if (!copy) {
+        fprintf(stderr, "Memory allocation failed for RuleReloader.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, path, n);
+    return copy;
+}
+
+/* ---------------------------------------------------------------
+ *   Grace period: wait until no reader can still be inside a
+ *   read-side section that began before epoch `target`
+ * --------------------------------------------------------------- */
+static void waitForReaders(RuleReloader *r, uint64_t target) {
+    struct timespec pause = { 0, RELOAD_POLL_NS };
+    int readers = atomic_load(&r->reader_count);
+    for (int i = 0; i < readers; i++) {
+        for (;;) {
+            uint64_t e = atomic_load(&r->reader_epoch[i]);
+            if (e == 0 || e >= target) break;
+            nanosleep(&pause, NULL);
+        }
+    }
+}
+
+/* ---------------------------------------------------------------
+ *   Swap in `fresh`, then reclaim the previous engine once the
+ *   grace period has elapsed
+ * --------------------------------------------------------------- */
+static void publishRuleEngine(RuleReloader *r, RuleEngine *fresh) {
+    RuleEngine *old = atomic_exchange(&r->current, fresh);
+    uint64_t target = atomic_fetch_add(&r->epoch, 1) + 1;
+    waitForReaders(r, target);
+    freeRuleEngine(old);
+    atomic_fetch_add(&r->reloads, 1);
+}
+
+/* ---------------------------------------------------------------
+ *   Reload thread: rebuild and publish on every request. Requests
+ *   that arrive during a rebuild are coalesced into one more.
+ * --------------------------------------------------------------- */
+static void *reloadThread(void *arg) {
+    RuleReloader *r = arg;
+    for (;;) {
+        if (sem_wait(&r->wake) != 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        while (sem_trywait(&r->wake) == 0) {}
+        if (atomic_load(&r->stop)) break;
+
+        RuleEngine *fresh = buildRuleEngine(r->rules_path, r->cache_path, r->alg);
+        if (!fresh) {
+            fprintf(stderr, "[-] Rule reload failed; keeping the current ruleset\n");
+            continue;
+        }
+        fresh->generation = atomic_load(&r->current)->generation + 1;
+        publishRuleEngine(r, fresh);
+        printf("[*] Ruleset reloaded (generation %llu)\n",
+               (unsigned long long)fresh->generation);
+    }
+    return NULL;
+}
+
+/* ---------------------------------------------------------------
+ *   Build the initial engine on the calling thread and start the
+ *   reload thread. Returns NULL if the rules cannot be loaded.
+ * --------------------------------------------------------------- */
+RuleReloader *startRuleReloader(const char *rules_path, const char *cache_path,
+                                AlgorithmType alg) {
+    RuleEngine *engine = buildRuleEngine(rules_path, cache_path, alg);
+    if (!engine) return NULL;
+
+    RuleReloader *r = calloc(1, sizeof(RuleReloader));
+    if (!r) {
+        fprintf(stderr, "Memory allocation failed for RuleReloader.\n");
+        exit(EXIT_FAILURE);
+    }
+    atomic_init(&r->current, engine);
+    atomic_init(&r->epoch, 1);
+    r->rules_path = copyPath(rules_path);
+    r->cache_path = copyPath(cache_path);
+    r->alg = alg;
+
+    if (sem_init(&r->wake, 0, 0) != 0) {
+        perror("sem_init");
+        exit(EXIT_FAILURE);
+    }
+    if (pthread_create(&r->thread, NULL, reloadThread, r) == 0)
+        atomic_store(&r->running, 1);
+    else
+        fprintf(stderr, "[!] Could not start rule reload thread; reloads disabled\n");
+    return r;
+}
+
+/* ---------------------------------------------------------------
+ *   Ask for a rebuild from the rules path. Only posts a semaphore,
+ *   so it is safe to call from a signal handler.
+ * --------------------------------------------------------------- */
+void requestRuleReload(RuleReloader *r) {
+    if (r) sem_post(&r->wake);
+}
+
+/* ---------------------------------------------------------------
+ *   Stop the reload thread and free the current engine. No reader
+ *   may be inside a read-side section.
+ * --------------------------------------------------------------- */
+void stopRuleReloader(RuleReloader *r) {
+    if (!r) return;
+    if (atomic_load(&r->running)) {
+        atomic_store(&r->stop, 1);
+        sem_post(&r->wake);
+        pthread_join(r->thread, NULL);
+    }
+    sem_destroy(&r->wake);
+    freeRuleEngine(atomic_load(&r->current));
+    free(r->rules_path);
+    free(r->cache_path);
+    free(r);
+}
+
+/* ---------------------------------------------------------------
+ *   Claim a reader slot for the calling thread. Returns the slot,
+ *   or -1 if all RELOAD_MAX_READERS slots are taken.
+ * --------------------------------------------------------------- */
+int ruleReaderRegister(RuleReloader *r) {
+    int slot = atomic_fetch_add(&r->reader_count, 1);
+    if (slot >= RELOAD_MAX_READERS) {
+        atomic_fetch_sub(&r->reader_count, 1);
+        return -1;
+    }
+    return slot;
+}
+
+/* ---------------------------------------------------------------
+ *   Enter a read-side section and return the current engine. The
+ *   engine stays valid until the matching ruleReadUnlock.
+ * --------------------------------------------------------------- */
+const RuleEngine *ruleReadLock(RuleReloader *r, int reader) {
+    atomic_store(&r->reader_epoch[reader], atomic_load(&r->epoch));
+    return atomic_load(&r->current);
+}
+
+/* ---------------------------------------------------------------
+ *                   Leave a read-side section
+ * --------------------------------------------------------------- */
+void ruleReadUnlock(RuleReloader *r, int reader) {
+    atomic_store_explicit(&r->reader_epoch[reader], 0, memory_order_release);
+}
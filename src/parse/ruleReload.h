@@ -0,0 +1,71 @@
+#ifndef SRC_PARSE_RULERELOAD_H_
+#define SRC_PARSE_RULERELOAD_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "parseRules.h"
+#include "ruleGroups.h"
+
+#define RELOAD_MAX_READERS  64
+
+/* ---------------------------------------------------------------
+ * RuleEngine:
+ *   Everything a scanning thread needs for one ruleset version:
+ *   the parsed rules and the compiled per-group matchers. An
+ *   engine is immutable once published.
+ * --------------------------------------------------------------- */
+typedef struct {
+    RuleSet        *rs;
+    RuleGroupTable *groups;
+    uint64_t        generation;
+} RuleEngine;
+
+/* ---------------------------------------------------------------
+ * RuleReloader:
+ *   Publishes the current RuleEngine to scanning threads and
+ *   swaps in rebuilt engines without blocking them (RCU style).
+ *
+ *   Readers bracket each use of the engine with ruleReadLock /
+ *   ruleReadUnlock, which only store their slot's epoch: the
+ *   global epoch while reading, 0 when quiescent. After swapping
+ *   `current`, the reload thread advances the epoch and frees the
+ *   old engine once every reader slot is quiescent or has entered
+ *   the new epoch, i.e. no reader can still hold the old pointer.
+ * --------------------------------------------------------------- */
+typedef struct {
+    _Atomic(RuleEngine *) current;
+    atomic_uint_fast64_t  epoch;
+    atomic_uint_fast64_t  reader_epoch[RELOAD_MAX_READERS];
+    atomic_int            reader_count;
+
+    char          *rules_path;
+    char          *cache_path;
+    AlgorithmType  alg;
+
+    pthread_t      thread;
+    sem_t          wake;
+    atomic_int     stop;
+    atomic_int     running;
+    atomic_uint_fast64_t reloads;
+} RuleReloader;
+
+/* ---------------------------------------------------------------
+ *                     Rule Reload API
+ * --------------------------------------------------------------- */
+RuleEngine *buildRuleEngine(const char *rules_path, const char *cache_path,
+                            AlgorithmType alg);
+void freeRuleEngine(RuleEngine *engine);
+
+RuleReloader *startRuleReloader(const char *rules_path, const char *cache_path,
+                                AlgorithmType alg);
+void requestRuleReload(RuleReloader *r);
+void stopRuleReloader(RuleReloader *r);
+
+int ruleReaderRegister(RuleReloader *r);
+const RuleEngine *ruleReadLock(RuleReloader *r, int reader);
+void ruleReadUnlock(RuleReloader *r, int reader);
+
+#endif  // SRC_PARSE_RULERELOAD_H_
@@ -0,0 +1,187 @@
+/*
+ *                  Per-Flow Incremental Detection
+ *
+ * ---------------------------------------------------------------
+ * Connects TCP reassembly to the rule groups. Each flow direction
+ * keeps its own engine state, so every in-order segment is fed to
+ * the engines exactly once and a pattern split across segments is
+ * still found: Aho–Corasick resumes from the automaton state the
+ * previous segment ended in (stored per flow, 4 bytes per group),
+ * the skip-based engines rescan only their short carried tail.
+ * Reassembled bytes are never buffered or rescanned. Rules are
+ * evaluated against the segment just delivered, or against the
+ * stream prefix joined to it when their fast pattern began in an
+ * earlier segment.
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "streamScan.h"
+
+/* ---------------------------------------------------------------
+ *   Set up a direction's scan state on its first delivered bytes
+ * --------------------------------------------------------------- */
+static FlowScan *newFlowScan(const RuleGroupTable *groups, const Flow *f, int dir) {
+    FlowScan *fs = calloc(1, sizeof(FlowScan));
+    if (!fs) {
+        fprintf(stderr, "Memory allocation failed for FlowScan.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Ports as seen by packets of this direction
+    int src = dir == FLOW_DIR_CLIENT ? f->client_end : 1 - f->client_end;
+    fs->group_count = selectRuleGroups(groups, f->key.ip_proto,
+                                       f->key.port[src], f->key.port[1 - src],
+                                       fs->groups);
+    if (fs->group_count == 0 || matcher_resumable(fs->groups[0]->matcher))
+        return fs;
+
+    fs->streams = calloc((size_t)fs->group_count, sizeof(MatcherStream));
+    if (!fs->streams) {
+        fprintf(stderr, "Memory allocation failed for FlowScan.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int g = 0; g < fs->group_count; g++)
+        matcher_stream_init(&fs->streams[g], fs->groups[g]->matcher);
+    return fs;
+}
+
+/* ---------------------------------------------------------------
+ *   Restart the engine state at a discontinuity in the stream
+ * --------------------------------------------------------------- */
+static void restartFlowScan(FlowScan *fs, uint64_t offset) {
+    for (int g = 0; g < fs->group_count; g++) {
+        fs->state[g] = 0;
+        if (!fs->streams) continue;
+        matcher_stream_finish(&fs->streams[g]);
+        matcher_stream_init(&fs->streams[g], fs->groups[g]->matcher);
+    }
+    fs->stream_base = offset;
+    fs->prefix_len = 0;
+}
+
+/* ---------------------------------------------------------------
+ *   Keep the last STREAM_PREFIX_BYTES of the stream
+ * --------------------------------------------------------------- */
+static void updatePrefix(FlowScan *fs, const uint8_t *data, uint32_t len) {
+    if (len >= STREAM_PREFIX_BYTES) {
+        memcpy(fs->prefix, data + len - STREAM_PREFIX_BYTES, STREAM_PREFIX_BYTES);
+        fs->prefix_len = STREAM_PREFIX_BYTES;
+        return;
+    }
+    size_t keep = STREAM_PREFIX_BYTES - len;
+    if (keep > fs->prefix_len) keep = fs->prefix_len;
+    memmove(fs->prefix, fs->prefix + fs->prefix_len - keep, keep);
+    memcpy(fs->prefix + keep, data, len);
+    fs->prefix_len = (uint16_t)(keep + len);
+}
+
+/* ---------------------------------------------------------------
+ *   StreamDeliverFn: scan the next in-order bytes of a direction
+ * --------------------------------------------------------------- */
+static void onStreamBytes(Flow *f, int dir, const uint8_t *data, uint32_t len,
+                          uint64_t offset, int gap, void *ctx) {
+    StreamScanner *ss = ctx;
+    FlowHalf *h = &f->half[dir];
+    FlowScan *fs = h->scan;
+    if (!fs) {
+        fs = newFlowScan(ss->groups, f, dir);
+        fs->stream_base = offset;
+        h->scan = fs;
+    } else if (gap) {
+        restartFlowScan(fs, offset);
+    }
+
+    RuleMatchContext *rm = ss->rm;
+    beginRuleSegment(rm, data, len, offset - fs->stream_base,
+                     fs->prefix, fs->prefix_len);
+    for (int g = 0; g < fs->group_count; g++) {
+        if (fs->streams)
+            feedRuleGroupStream(fs->groups[g], &fs->streams[g], rm);
+        else
+            fs->state[g] = resumeRuleGroupScan(fs->groups[g], fs->state[g], rm);
+    }
+    updatePrefix(fs, data, len);
+}
+
+/* ---------------------------------------------------------------
+ *   FlowReleaseFn: end both directions' matcher streams
+ * --------------------------------------------------------------- */
+static void releaseFlowScan(Flow *f, void *ctx) {
+    StreamScanner *ss = ctx;
+    ss->flows_closed++;
+    for (int d = 0; d < 2; d++) {
+        FlowScan *fs = f->half[d].scan;
+        if (!fs) continue;
+        if (fs->streams) {
+            for (int g = 0; g < fs->group_count; g++)
+                matcher_stream_finish(&fs->streams[g]);
+            free(fs->streams);
+        }
+        free(fs);
+        f->half[d].scan = NULL;
+    }
+}
+
+/* ---------------------------------------------------------------
+ *            Prepare to scan the TCP flows of a capture
+ * --------------------------------------------------------------- */
+void initStreamScanner(StreamScanner *ss, const RuleGroupTable *groups,
+                       RuleMatchContext *rm) {
+    memset(ss, 0, sizeof(*ss));
+    ss->groups = groups;
+    ss->rm = rm;
+    ss->flows = createFlowTable(FLOW_TABLE_MAX_FLOWS, FLOW_IDLE_TIMEOUT_NS,
+                                releaseFlowScan, ss);
+}
+
+/* ---------------------------------------------------------------
+ *   Track one decoded TCP packet (with or without payload) and
+ *   scan the stream bytes it completes. A flow ends on RST, once
+ *   both directions have sent FIN, after FLOW_IDLE_TIMEOUT_NS
+ *   without packets, or when evicted as the least recently seen
+ *   of FLOW_TABLE_MAX_FLOWS.
+ * --------------------------------------------------------------- */
+void scanTcpPacket(StreamScanner *ss, const DecodedPacket *dp, uint64_t ts_ns) {
+    advanceFlowClock(ss->flows, ts_ns);
+
+    int dir;
+    Flow *f = lookupFlow(ss->flows, dp, ts_ns, 1, &dir);
+
+    reassembleTcp(f, dir, dp, &ss->tcp, onStreamBytes, ss);
+
+    if ((dp->tcp_flags & TCP_FLAG_RST) || (f->half[0].fin && f->half[1].fin))
+        removeFlow(ss->flows, f);
+}
+
+/* ---------------------------------------------------------------
+ *                Print flow and reassembly stats
+ * --------------------------------------------------------------- */
+void printStreamScanStats(const StreamScanner *ss) {
+    const TcpReassemblyStats *t = &ss->tcp;
+    printf("\n[TCP Reassembly]\n");
+    printf("  Flows                  : %" PRIu64 "\n", ss->flows->created);
+    printf("  Flows closed           : %" PRIu64 "\n", ss->flows_closed);
+    printf("  Flows expired / evicted: %" PRIu64 " / %" PRIu64 "\n",
+           ss->flows->expired, ss->flows->evicted);
+    printf("  Segments with payload  : %" PRIu64 "\n", t->segments);
+    printf("  In order               : %" PRIu64 "\n", t->in_order);
+    printf("  Out of order (queued)  : %" PRIu64 "\n", t->out_of_order);
+    printf("  Retransmitted          : %" PRIu64 "\n", t->retransmitted);
+    printf("  Overlap bytes trimmed  : %" PRIu64 "\n", t->overlap_bytes);
+    printf("  Beyond window          : %" PRIu64 "\n", t->dropped);
+    printf("  Gaps skipped           : %" PRIu64 "\n", t->gaps_skipped);
+    printf("  Stream bytes scanned   : %" PRIu64 "\n", t->bytes_delivered);
+}
+
+/* ---------------------------------------------------------------
+ *   Release every remaining flow. Matches were reported as their
+ *   bytes arrived, so nothing is flushed.
+ * --------------------------------------------------------------- */
+void freeStreamScanner(StreamScanner *ss) {
+    freeFlowTable(ss->flows);
+    ss->flows = NULL;
+}
@@ -0,0 +1,60 @@
+#ifndef SRC_PARSE_STREAMSCAN_H_
+#define SRC_PARSE_STREAMSCAN_H_
+
+#include <stdint.h>
+
+#include "evalRules.h"
+#include "ruleGroups.h"
+#include "../algorithms/matcher.h"
+#include "../capture/flowTable.h"
+#include "../capture/tcpReassembly.h"
+
+#define STREAM_PREFIX_BYTES   256      // stream bytes kept for cross-segment evaluation
+#define FLOW_IDLE_TIMEOUT_NS  (120ull * 1000000000ull)
+#define FLOW_TABLE_MAX_FLOWS  (1u << 20)  // concurrent flows before LRU eviction
+
+/* ---------------------------------------------------------------
+ * FlowScan:
+ *   Detection state of one flow direction: the rule groups chosen
+ *   by its ports, the engine's stream state per group and the last
+ *   STREAM_PREFIX_BYTES of the stream for evaluating rules whose
+ *   fast pattern straddles two segments. For a resumable engine
+ *   (Aho–Corasick) the stream state is just the 4-byte automaton
+ *   state in `state`; other engines get a MatcherStream carrying
+ *   a short tail. The reassembled stream itself is never kept.
+ *   stream_base is the stream offset at which the engine state
+ *   last (re)started.
+ * --------------------------------------------------------------- */
+typedef struct {
+    const RuleGroup *groups[2];
+    int              group_count;
+    uint32_t         state[2];
+    MatcherStream   *streams;       // NULL for resumable engines
+    uint64_t         stream_base;
+    uint16_t         prefix_len;
+    unsigned char    prefix[STREAM_PREFIX_BYTES];
+} FlowScan;
+
+/* ---------------------------------------------------------------
+ * StreamScanner:
+ *   Scans TCP payloads as reassembled per-flow streams, evaluating
+ *   rules through `rm` as bytes are delivered in order.
+ * --------------------------------------------------------------- */
+typedef struct {
+    const RuleGroupTable *groups;
+    RuleMatchContext     *rm;
+    FlowTable            *flows;
+    TcpReassemblyStats    tcp;
+    uint64_t              flows_closed;
+} StreamScanner;
+
+/* ---------------------------------------------------------------
+ *                     Stream Scanning API
+ * --------------------------------------------------------------- */
+void initStreamScanner(StreamScanner *ss, const RuleGroupTable *groups,
+                       RuleMatchContext *rm);
+void scanTcpPacket(StreamScanner *ss, const DecodedPacket *dp, uint64_t ts_ns);
+void printStreamScanStats(const StreamScanner *ss);
+void freeStreamScanner(StreamScanner *ss);
+
+#endif  // SRC_PARSE_STREAMSCAN_H_
@@ -0,0 +1,197 @@
+/*
+ *               Aho–Corasick Scan Layout Benchmark
+ *
+ * ---------------------------------------------------------------
+ * Builds one Aho–Corasick automaton over every pattern of the
+ * ruleset in each scan layout and reports, per layout, the build
+ * time, the bytes the automaton holds once frozen and the scan
+ * throughput over the packet payloads of real captures. Every
+ * layout's matches are checked against the NFA layout's.
+ *
+ * Usage: acLayoutBench [capture_path] [rules_path]
+ *   capture_path is a capture file or a directory searched for
+ *   .pcap / .pcapng files (default data/tests/pcaps). Without any
+ *   payload, the scan text is every pattern back to back.
+ * --------------------------------------------------------------- */
+
+// Define the POSIX source to have access to clock_gettime
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/algorithms/AC/ac.h"
+#include "../src/parse/analytics.h"
+#include "../src/parse/parseRules.h"
+#include "../src/parse/loadRules.h"
+#include "../src/capture/captureWalk.h"
+
+#define CAPTURE_PATH  "./data/tests/pcaps"
+#define RULESET_PATH  "./data/ruleset/snort3-community-rules/snort3-community.rules"
+#define MAX_TEXT      (256u << 20)
+#define SCAN_ROUNDS   3
+
+static const struct {
+    ACLayout    layout;
+    const char *name;
+} LAYOUTS[] = {
+    { AC_LAYOUT_NFA, "nfa" },
+    { AC_LAYOUT_DFA, "dfa" },
+    { AC_LAYOUT_HYBRID, "hybrid" },
+    { AC_LAYOUT_DOUBLE_ARRAY, "darray" },
+};
+
+/* ---------------------------------------------------------------
+ *   Payload bytes of the captures, back to back
+ * --------------------------------------------------------------- */
+typedef struct {
+    char  *data;
+    size_t len;
+    size_t cap;
+} ScanText;
+
+static void append_text(ScanText *t, const void *data, size_t len) {
+    if (len > MAX_TEXT - t->len) len = MAX_TEXT - t->len;
+    if (t->len + len > t->cap) {
+        while (t->len + len > t->cap)
+            t->cap = t->cap ? t->cap * 2 : (1u << 20);
+        t->data = realloc(t->data, t->cap);
+        if (!t->data) {
+            fprintf(stderr, "Memory allocation failed for scan text.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(t->data + t->len, data, len);
+    t->len += len;
+}
+
+// CapturePacketFn: append a packet's payload, until the text is full
+static int collect_payload(const DecodedPacket *dp, void *ctx) {
+    ScanText *t = ctx;
+    if (dp->payload_len) append_text(t, dp->payload, dp->payload_len);
+    return t->len < MAX_TEXT;
+}
+
+/* ---------------------------------------------------------------
+ *   Order-independent digest of the matches reported by a scan
+ * --------------------------------------------------------------- */
+typedef struct {
+    uint64_t matches;
+    uint64_t digest;
+} ScanDigest;
+
+static void on_bench_match(int pattern_id, uint64_t end, void *ctx) {
+    ScanDigest *d = ctx;
+    uint64_t h = ((uint64_t)pattern_id + 1) * 0x9E3779B97F4A7C15ull;
+    h ^= end * 0xC2B2AE3D27D4EB4Full;
+    d->digest += h ^ (h >> 31);
+    d->matches++;
+}
+
+static double elapsed_sec(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* ---------------------------------------------------------------
+ *   Build, measure and scan with one layout. The best of
+ *   SCAN_ROUNDS scans is reported.
+ * --------------------------------------------------------------- */
+static ScanDigest bench_layout(const PatternSet *ps, ACLayout layout, const char *name,
+                               const ScanText *t, size_t nfa_bytes) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    AhoCorasick *ac = ac_create();
+    ac_set_layout(ac, layout);
+    for (int i = 0; i < ps->pattern_count; i++)
+        ac_add_pattern(ac, (const char *)ps_pattern(ps, i),
+                       (size_t)ps->pattern_lens[i], ps->nocase[i]);
+    ac_build(ac);
+    ac_freeze(ac);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double build_sec = elapsed_sec(&t0, &t1);
+    size_t bytes = ac_memory_bytes(ac);
+
+    char note[64] = "";
+    ScanDigest d = {0};
+    double best = 0.0;
+    for (int r = 0; r < SCAN_ROUNDS; r++) {
+        AlgorithmStats s = {0};
+        d.matches = d.digest = 0;
+        ac_search(ac, t->data, t->len, &s, on_bench_match, &d);
+        if (r == 0 || s.elapsed_sec < best) best = s.elapsed_sec;
+    }
+
+    if (layout == AC_LAYOUT_HYBRID)
+        snprintf(note, sizeof(note), "  (%d dense, %d sparse)",
+                 ac->hyb_dense_count, ac->hyb_sparse_count);
+    else if (layout == AC_LAYOUT_DOUBLE_ARRAY)
+        snprintf(note, sizeof(note), "  (%d slots for %d states)",
+                 ac->da_size, ac->node_count);
+    printf("  %-6s %9.1f ms %10.2f MB %8.2fx %10.2f MB/s %12llu%s\n", name,
+           build_sec * 1e3, (double)bytes / BYTES_PER_MB,
+           nfa_bytes ? (double)bytes / (double)nfa_bytes : 1.0,
+           best > 0 ? ((double)t->len / BYTES_PER_MB) / best : 0.0,
+           (unsigned long long)d.matches, note);
+    ac_destroy(ac);
+    return d;
+}
+
+int main(int argc, char *argv[]) {
+    const char *capture_path = argc > 1 ? argv[1] : CAPTURE_PATH;
+    const char *rules_path = argc > 2 ? argv[2] : RULESET_PATH;
+
+    global_mem_stats = calloc(1, sizeof(MemoryStats));
+
+    RuleSet *rs = loadSnortRules(rules_path, 0);
+    if (!rs) {
+        fprintf(stderr, "[-] Failed to load rules from %s\n", rules_path);
+        free(global_mem_stats);
+        return EXIT_FAILURE;
+    }
+    const PatternSet *ps = rs->ps;
+
+    ScanText t = {0};
+    walkCapturePackets(capture_path, collect_payload, &t);
+    if (t.len == 0) {
+        for (int i = 0; i < ps->pattern_count; i++) {
+            append_text(&t, ps_pattern(ps, i), (size_t)ps->pattern_lens[i]);
+            append_text(&t, "\n", 1);
+        }
+    }
+    printf("[*] Patterns: %d, scan text: %zu bytes\n", ps->pattern_count, t.len);
+
+    // The NFA layout is the reference for both memory and matches
+    AhoCorasick *ref = ac_create();
+    for (int i = 0; i < ps->pattern_count; i++)
+        ac_add_pattern(ref, (const char *)ps_pattern(ps, i),
+                       (size_t)ps->pattern_lens[i], ps->nocase[i]);
+    ac_build(ref);
+    size_t nfa_bytes = ac_memory_bytes(ref);
+    printf("[*] States: %d, byte classes: %d\n\n", ref->node_count, ref->class_count);
+    ac_destroy(ref);
+
+    printf("  %-6s %12s %13s %9s %15s %12s\n", "layout", "build", "memory",
+           "vs nfa", "throughput", "matches");
+    int ok = 1;
+    ScanDigest want = {0};
+    for (size_t i = 0; i < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); i++) {
+        ScanDigest got = bench_layout(ps, LAYOUTS[i].layout, LAYOUTS[i].name, &t, nfa_bytes);
+        if (i == 0) {
+            want = got;
+        } else if (got.matches != want.matches || got.digest != want.digest) {
+            printf("[-] %s: matches differ from the nfa layout\n", LAYOUTS[i].name);
+            ok = 0;
+        }
+    }
+    if (ok) printf("\n[+] All layouts report identical matches\n");
+
+    free(t.data);
+    freeRuleSet(rs);
+    free(global_mem_stats);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,251 @@
+/*
+ *          Incremental Aho–Corasick Update Benchmark
+ *
+ * ---------------------------------------------------------------
+ * Measures the latency of applying a small rule delta to a built
+ * Aho–Corasick automaton with ac_insert_pattern and
+ * ac_remove_pattern, against rebuilding the automaton from the
+ * whole ruleset. After each step the patched automaton is checked
+ * against a freshly built one by scanning the same text with both.
+ *
+ * Usage: acUpdateBench [rules_path] [delta] [file_to_scan]
+ *   Without a file, the scan text is every pattern of the ruleset
+ *   back to back, so every pattern matches at least once.
+ * --------------------------------------------------------------- */
+
+// Define the POSIX source to have access to clock_gettime and CLOCK_MONOTONIC
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/algorithms/AC/ac.h"
+#include "../src/parse/analytics.h"
+#include "../src/parse/parseRules.h"
+#include "../src/parse/loadRules.h"
+
+#define RULESET_PATH  "./data/ruleset/snort3-community-rules/snort3-community.rules"
+#define DEFAULT_DELTA 16
+#define REBUILD_ROUNDS 3
+
+/* ---------------------------------------------------------------
+ *   Order-independent digest of the matches reported by a scan,
+ *   keyed by PatternSet index so that automata with different
+ *   pattern ids can be compared
+ * --------------------------------------------------------------- */
+typedef struct {
+    const int *pid_to_ps;
+    uint64_t   matches;
+    uint64_t   digest;
+} ScanDigest;
+
+static void on_bench_match(int pattern_id, uint64_t end, void *ctx) {
+    ScanDigest *d = ctx;
+    uint64_t h = ((uint64_t)d->pid_to_ps[pattern_id] + 1) * 0x9E3779B97F4A7C15ull;
+    h ^= end * 0xC2B2AE3D27D4EB4Full;
+    d->digest += h ^ (h >> 31);
+    d->matches++;
+}
+
+static ScanDigest scan_digest(AhoCorasick *ac, const int *pid_to_ps,
+                              const char *text, size_t len) {
+    ScanDigest d = { pid_to_ps, 0, 0 };
+    AlgorithmStats s = {0};
+    ac_search(ac, text, len, &s, on_bench_match, &d);
+    return d;
+}
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1e6 +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/* ---------------------------------------------------------------
+ *   Build an automaton over the patterns of ps not marked in skip
+ *   (NULL: all), recording each pattern id's PatternSet index
+ * --------------------------------------------------------------- */
+static AhoCorasick *build_automaton(const PatternSet *ps, const uint8_t *skip,
+                                    int *pid_to_ps) {
+    AhoCorasick *ac = ac_create();
+    for (int i = 0; i < ps->pattern_count; i++) {
+        if (skip && skip[i]) continue;
+        pid_to_ps[ac->pattern_count] = i;
+        ac_add_pattern(ac, (const char *)ps_pattern(ps, i),
+                       (size_t)ps->pattern_lens[i], ps->nocase[i]);
+    }
+    ac_build(ac);
+    return ac;
+}
+
+/* ---------------------------------------------------------------
+ *   Scan text: the named file, or all patterns concatenated
+ * --------------------------------------------------------------- */
+static char *load_scan_text(const char *path, const PatternSet *ps, size_t *len) {
+    if (path) {
+        FILE *fp = fopen(path, "rb");
+        if (!fp) {
+            perror(path);
+            return NULL;
+        }
+        fseek(fp, 0, SEEK_END);
+        long size = ftell(fp);
+        rewind(fp);
+        char *text = malloc(size > 0 ? (size_t)size : 1);
+        if (!text) {
+            fprintf(stderr, "Memory allocation failed for scan text.\n");
+            exit(EXIT_FAILURE);
+        }
+        *len = fread(text, 1, size > 0 ? (size_t)size : 0, fp);
+        fclose(fp);
+        return text;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < ps->pattern_count; i++)
+        total += (size_t)ps->pattern_lens[i] + 1;
+    char *text = malloc(total + 1);
+    if (!text) {
+        fprintf(stderr, "Memory allocation failed for scan text.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t pos = 0;
+    for (int i = 0; i < ps->pattern_count; i++) {
+        memcpy(text + pos, ps_pattern(ps, i), (size_t)ps->pattern_lens[i]);
+        pos += (size_t)ps->pattern_lens[i];
+        text[pos++] = '\n';
+    }
+    *len = pos;
+    return text;
+}
+
+static int report_check(const char *what, ScanDigest got, ScanDigest want) {
+    int ok = got.matches == want.matches && got.digest == want.digest;
+    printf("[%c] %s: %llu matches (fresh build: %llu) %s\n", ok ? '+' : '-', what,
+           (unsigned long long)got.matches, (unsigned long long)want.matches,
+           ok ? "OK" : "MISMATCH");
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    const char *rules_path = argc > 1 ? argv[1] : RULESET_PATH;
+    int delta = argc > 2 ? atoi(argv[2]) : DEFAULT_DELTA;
+    const char *scan_path = argc > 3 ? argv[3] : NULL;
+
+    global_mem_stats = calloc(1, sizeof(MemoryStats));
+
+    RuleSet *rs = loadSnortRules(rules_path, 0);
+    if (!rs) {
+        fprintf(stderr, "[-] Failed to load rules from %s\n", rules_path);
+        free(global_mem_stats);
+        return EXIT_FAILURE;
+    }
+    const PatternSet *ps = rs->ps;
+    int n = ps->pattern_count;
+    if (delta < 1) delta = 1;
+    if (delta > n / 2) delta = n / 2;
+    if (delta < 1) {
+        fprintf(stderr, "[-] Ruleset has too few patterns\n");
+        freeRuleSet(rs);
+        free(global_mem_stats);
+        return EXIT_FAILURE;
+    }
+
+    size_t text_len = 0;
+    char *text = load_scan_text(scan_path, ps, &text_len);
+    if (!text) {
+        freeRuleSet(rs);
+        free(global_mem_stats);
+        return EXIT_FAILURE;
+    }
+
+    // The delta: patterns spread evenly over the ruleset
+    uint8_t *in_delta = calloc((size_t)n, 1);
+    int *delta_ps = malloc((size_t)delta * sizeof(int));
+    int *delta_pid = malloc((size_t)delta * sizeof(int));
+    int *full_map = malloc((size_t)n * sizeof(int));
+    int *inc_map = malloc((size_t)(n + delta) * sizeof(int));
+    if (!in_delta || !delta_ps || !delta_pid || !full_map || !inc_map) {
+        fprintf(stderr, "Memory allocation failed for benchmark tables.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int k = 0; k < delta; k++) {
+        delta_ps[k] = (int)(((int64_t)k * n + n / 2) / delta);
+        in_delta[delta_ps[k]] = 1;
+    }
+
+    printf("[*] Patterns: %d, delta: %d, scan text: %zu bytes\n", n, delta, text_len);
+
+    // Full rebuild of the updated ruleset: the cost being avoided
+    double rebuild_us = 0.0;
+    AhoCorasick *full = NULL;
+    for (int r = 0; r < REBUILD_ROUNDS; r++) {
+        struct timespec t0, t1;
+        ac_destroy(full);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        full = build_automaton(ps, NULL, full_map);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double us = elapsed_us(&t0, &t1);
+        if (r == 0 || us < rebuild_us) rebuild_us = us;
+    }
+    ScanDigest want_full = scan_digest(full, full_map, text, text_len);
+    ac_destroy(full);
+
+    // Start from the ruleset without the delta
+    AhoCorasick *ac = build_automaton(ps, in_delta, inc_map);
+    ScanDigest want_base = scan_digest(ac, inc_map, text, text_len);
+
+    double insert_us = 0.0, insert_max = 0.0;
+    for (int k = 0; k < delta; k++) {
+        int i = delta_ps[k];
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        delta_pid[k] = ac_insert_pattern(ac, (const char *)ps_pattern(ps, i),
+                                         (size_t)ps->pattern_lens[i], ps->nocase[i]);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double us = elapsed_us(&t0, &t1);
+        insert_us += us;
+        if (us > insert_max) insert_max = us;
+        inc_map[delta_pid[k]] = i;
+    }
+    ScanDigest got_full = scan_digest(ac, inc_map, text, text_len);
+
+    double remove_us = 0.0, remove_max = 0.0;
+    for (int k = 0; k < delta; k++) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        ac_remove_pattern(ac, delta_pid[k]);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double us = elapsed_us(&t0, &t1);
+        remove_us += us;
+        if (us > remove_max) remove_max = us;
+    }
+    ScanDigest got_base = scan_digest(ac, inc_map, text, text_len);
+    ac_destroy(ac);
+
+    printf("\n=== Incremental Update vs Full Rebuild ===\n");
+    printf("Full-Rebuild-Time: %.3f ms\n", rebuild_us / 1e3);
+    printf("Insert-Delta-Time: %.3f ms (mean %.2f us, max %.2f us per pattern)\n",
+           insert_us / 1e3, insert_us / delta, insert_max);
+    printf("Remove-Delta-Time: %.3f ms (mean %.2f us, max %.2f us per pattern)\n",
+           remove_us / 1e3, remove_us / delta, remove_max);
+    if (insert_us > 0.0 && remove_us > 0.0)
+        printf("Speedup-vs-Rebuild: insert %.1fx, remove %.1fx\n",
+               rebuild_us / insert_us, rebuild_us / remove_us);
+
+    int ok = report_check("After insert", got_full, want_full);
+    ok &= report_check("After remove", got_base, want_base);
+
+    free(in_delta);
+    free(delta_ps);
+    free(delta_pid);
+    free(full_map);
+    free(inc_map);
+    free(text);
+    freeRuleSet(rs);
+    free(global_mem_stats);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,140 @@
+/*
+ *                  Matching Engine Agreement Check
+ *
+ * ---------------------------------------------------------------
+ * Scans a few hand-made buffers against every rule with each
+ * matching engine, the way a raw (non-capture) file is scanned,
+ * and checks that every engine raises the same number of alerts.
+ * Whichever engine is chosen is only a prefilter, so the alerts
+ * must never depend on it. A buffer may also have to raise as
+ * many alerts as another one, e.g. the same bytes placed across
+ * a chunk boundary and inside one chunk.
+ *
+ * Usage: engineCheck [rules_path]
+ * --------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/algorithms/matcher.h"
+#include "../src/parse/analytics.h"
+#include "../src/parse/parseRules.h"
+#include "../src/parse/loadRules.h"
+#include "../src/parse/evalRules.h"
+#include "../src/parse/ruleGroups.h"
+
+#define RULESET_PATH  "./data/ruleset/snort3-community-rules/snort3-community.rules"
+#define CHUNK_BYTES   (1u << 20)
+
+// The first engine, the default, is the reference for the others
+static const AlgorithmType ENGINES[] = {
+    ALG_AC, ALG_AC_DFA, ALG_AC_HYBRID, ALG_AC_DA,
+    ALG_SH, ALG_WM_DET, ALG_WM_PROB, ALG_BM,
+};
+
+/* ---------------------------------------------------------------
+ *   Test buffers
+ * --------------------------------------------------------------- */
+typedef struct {
+    const char    *name;
+    unsigned char *data;
+    size_t         len;
+    int            same_as;  // case this one must agree with, or -1
+} CheckCase;
+
+// `s` placed `pad` zero bytes into the buffer
+static unsigned char *place_text(const char *s, size_t pad, size_t *len) {
+    size_t n = strlen(s);
+    *len = pad + n;
+    unsigned char *data = calloc(*len, 1);
+    if (!data) {
+        fprintf(stderr, "Memory allocation failed for check text.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(data + pad, s, n);
+    return data;
+}
+
+// nocase contents written in a case the rule does not use
+static void mixed_case(CheckCase *c) {
+    c->name = "mixed case";
+    c->data = place_text("xx LOGIN FAILED FOR USER 'SA' yy "
+                         "221 GOODBYE HAPPY R00TING zz", 0, &c->len);
+    c->same_as = -1;
+}
+
+/*
+ * A case-sensitive content ("[masscan/1.0]") written in another case
+ * starting 4 bytes before a chunk boundary, and the same bytes with
+ * the content inside the first chunk
+ */
+static void chunk_boundary(CheckCase *c, CheckCase *inside) {
+    inside->name = "inside one chunk";
+    inside->data = place_text("[MASscan/1.0]", CHUNK_BYTES - 100, &inside->len);
+    inside->same_as = -1;
+    c->name = "chunk boundary";
+    c->data = place_text("[MASscan/1.0]", CHUNK_BYTES - 4, &c->len);
+    c->same_as = -1;
+}
+
+static uint64_t count_alerts(const RuleSet *rs, const RuleGroup *g, const CheckCase *c) {
+    RuleMatchContext rm;
+    initRuleMatchContext(&rm, rs);
+    beginRuleBuffer(&rm, c->data, c->len);
+    scanRuleGroupChunked(g, &rm, CHUNK_BYTES);
+    uint64_t alerts = rm.alerts;
+    freeRuleMatchContext(&rm);
+    return alerts;
+}
+
+int main(int argc, char *argv[]) {
+    const char *rules_path = argc > 1 ? argv[1] : RULESET_PATH;
+
+    global_mem_stats = calloc(1, sizeof(MemoryStats));
+
+    RuleSet *rs = loadSnortRules(rules_path, 0);
+    if (!rs) {
+        fprintf(stderr, "[-] Failed to load rules from %s\n", rules_path);
+        free(global_mem_stats);
+        return EXIT_FAILURE;
+    }
+
+    CheckCase cases[3];
+    mixed_case(&cases[0]);
+    chunk_boundary(&cases[2], &cases[1]);
+    cases[2].same_as = 1;
+    const int ncases = (int)(sizeof(cases) / sizeof(cases[0]));
+
+    uint64_t want[sizeof(cases) / sizeof(cases[0])];
+    int ok = 1;
+    for (size_t e = 0; e < sizeof(ENGINES) / sizeof(ENGINES[0]); e++) {
+        RuleGroupTable *groups = buildRuleGroups(rs, ENGINES[e]);
+        const RuleGroup *all = allRulesGroup(groups);
+        for (int i = 0; i < ncases; i++) {
+            uint64_t got = count_alerts(rs, all, &cases[i]);
+            printf("  %-30s %-20s %6llu alerts\n", matcher_name(ENGINES[e]),
+                   cases[i].name, (unsigned long long)got);
+            if (e == 0) {
+                want[i] = got;
+            } else if (got != want[i]) {
+                printf("[-] %s: %s differs from %s\n", matcher_name(ENGINES[e]),
+                       cases[i].name, matcher_name(ENGINES[0]));
+                ok = 0;
+            }
+            int j = cases[i].same_as;
+            if (j >= 0 && got != want[j]) {
+                printf("[-] %s: %s differs from %s\n", matcher_name(ENGINES[e]),
+                       cases[i].name, cases[j].name);
+                ok = 0;
+            }
+        }
+        freeRuleGroups(groups);
+    }
+    if (ok) printf("\n[+] All engines raise identical alerts\n");
+
+    for (int i = 0; i < ncases; i++) free(cases[i].data);
+    freeRuleSet(rs);
+    free(global_mem_stats);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,204 @@
+/*
+ *                   Flow Table Insert/Lookup Benchmark
+ *
+ * ---------------------------------------------------------------
+ * Replays the TCP/UDP packet headers of real captures against the
+ * flow table at a target number of concurrent flows. Each replay
+ * round shifts every address by a round-specific value (the same
+ * for both endpoints, so both directions still meet in one flow),
+ * turning the captures' flows into as many distinct flows as
+ * needed. Four phases are timed:
+ *
+ *   insert   replay until the table holds the target flow count
+ *   lookup   replay the same packets again; every lookup must hit
+ *   miss     replay rounds never inserted; every lookup must miss
+ *   evict    insert another tenth of the target into the full
+ *            table, evicting the least recently seen flows
+ *
+ * Usage: flowTableBench [capture_path] [flows ...]
+ *   capture_path is a capture file or a directory searched for
+ *   .pcap / .pcapng files (default data/tests/pcaps); flows
+ *   default to 1M and 10M.
+ * --------------------------------------------------------------- */
+
+// Define the POSIX source to have access to clock_gettime
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/capture/captureWalk.h"
+#include "../src/capture/flowTable.h"
+
+#define CAPTURE_PATH    "./data/tests/pcaps"
+#define MAX_TEMPLATES   (1u << 22)
+#define IDLE_TIMEOUT_NS (120ull * 1000000000ull)
+
+/* ---------------------------------------------------------------
+ *   Packet headers collected from the captures
+ * --------------------------------------------------------------- */
+typedef struct {
+    DecodedPacket *pkts;
+    size_t         count;
+    size_t         cap;
+} TemplateList;
+
+static void add_template(TemplateList *l, const DecodedPacket *dp) {
+    if (l->count == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 4096;
+        l->pkts = realloc(l->pkts, l->cap * sizeof(DecodedPacket));
+        if (!l->pkts) {
+            fprintf(stderr, "Memory allocation failed for packet templates.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    DecodedPacket *t = &l->pkts[l->count++];
+    *t = *dp;
+    t->payload = NULL;
+    t->payload_len = 0;
+}
+
+/* ---------------------------------------------------------------
+ *   CapturePacketFn: collect the TCP/UDP packets of the captures
+ * --------------------------------------------------------------- */
+static int collect_template(const DecodedPacket *dp, void *ctx) {
+    TemplateList *l = ctx;
+    if (dp->ip_proto == IPPROTO_NUM_TCP || dp->ip_proto == IPPROTO_NUM_UDP)
+        add_template(l, dp);
+    return l->count < MAX_TEMPLATES;
+}
+
+/* ---------------------------------------------------------------
+ *   Template i of the replay, shifted into round r. IPv4 rounds
+ *   change the low three address bytes, IPv6 the low eight.
+ * --------------------------------------------------------------- */
+static void replay_packet(const TemplateList *l, size_t i, uint32_t r, DecodedPacket *out) {
+    *out = l->pkts[i];
+    uint8_t shift[8] = { (uint8_t)r, (uint8_t)(r >> 8), (uint8_t)(r >> 16),
+                         (uint8_t)(r >> 24), 0x5A, 0xC3, 0x3C, 0xA5 };
+    int first = out->ip_version == 4 ? 1 : 8;
+    int last = out->ip_version == 4 ? 4 : 16;
+    for (int b = first; b < last; b++) {
+        out->src_addr[b] ^= shift[(b - first) % 8];
+        out->dst_addr[b] ^= shift[(b - first) % 8];
+    }
+}
+
+static double elapsed_sec(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void report_phase(const char *name, uint64_t ops, double sec, const char *check) {
+    printf("  %-7s: %10llu ops  %8.2f Mops/s  %7.1f ns/op  %s\n", name,
+           (unsigned long long)ops, sec > 0 ? (double)ops / sec / 1e6 : 0.0,
+           ops ? sec * 1e9 / (double)ops : 0.0, check);
+}
+
+/* ---------------------------------------------------------------
+ *   Run the four phases at `target` concurrent flows. Returns 0
+ *   if every lookup hit or missed as it should.
+ * --------------------------------------------------------------- */
+static int bench_flows(const TemplateList *l, size_t target) {
+    FlowTable *t = createFlowTable(target, IDLE_TIMEOUT_NS, NULL, NULL);
+    printf("\n[*] %zu flows: table reserves %.1f MB (%zu index slots, %zu B/flow)\n",
+           target, (double)flowTableBytes(t) / (1024.0 * 1024.0),
+           t->capacity, sizeof(Flow));
+
+    struct timespec t0, t1;
+    DecodedPacket dp;
+    int dir;
+
+    // Insert: replay whole rounds until the pool is full
+    uint64_t ops = 0;
+    uint32_t rounds = 0;
+    size_t last_i = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (t->flow_count < target) {
+        for (last_i = 0; last_i < l->count && t->flow_count < target; last_i++) {
+            replay_packet(l, last_i, rounds, &dp);
+            lookupFlow(t, &dp, 0, 1, &dir);
+            ops++;
+        }
+        rounds++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    report_phase("insert", ops, elapsed_sec(&t0, &t1), "");
+
+    // Lookup: the same packets, all of whose flows are present
+    uint64_t misses = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t r = 0; r < rounds; r++) {
+        size_t n = r + 1 == rounds ? last_i : l->count;
+        for (size_t i = 0; i < n; i++) {
+            replay_packet(l, i, r, &dp);
+            misses += lookupFlow(t, &dp, 0, 0, &dir) == NULL;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    int ok = misses == 0;
+    report_phase("lookup", ops, elapsed_sec(&t0, &t1), ok ? "all hit" : "MISSES");
+
+    // Miss: as many lookups from rounds never inserted
+    uint64_t hits = 0, miss_ops = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t r = 0x800000u; miss_ops < ops; r++) {
+        for (size_t i = 0; i < l->count && miss_ops < ops; i++, miss_ops++) {
+            replay_packet(l, i, r, &dp);
+            hits += lookupFlow(t, &dp, 0, 0, &dir) != NULL;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ok &= hits == 0;
+    report_phase("miss", miss_ops, elapsed_sec(&t0, &t1), hits ? "HITS" : "all miss");
+
+    // Evict: a tenth more flows, one tick later, into the full table
+    size_t extra = target / 10 ? target / 10 : 1;
+    uint64_t created = 0, evict_ops = 0;
+    uint64_t now = FLOW_TICK_NS;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t r = 0xC00000u; created < extra; r++) {
+        for (size_t i = 0; i < l->count && created < extra; i++, evict_ops++) {
+            replay_packet(l, i, r, &dp);
+            uint64_t before = t->created;
+            lookupFlow(t, &dp, now, 1, &dir);
+            created += t->created - before;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    char note[64];
+    snprintf(note, sizeof(note), "%llu evicted", (unsigned long long)t->evicted);
+    report_phase("evict", evict_ops, elapsed_sec(&t0, &t1), note);
+
+    freeFlowTable(t);
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : CAPTURE_PATH;
+
+    TemplateList l = {0};
+    walkCapturePackets(path, collect_template, &l);
+    if (l.count == 0) {
+        fprintf(stderr, "[-] No TCP/UDP packets found under %s\n", path);
+        free(l.pkts);
+        return EXIT_FAILURE;
+    }
+    printf("[*] Replaying %zu TCP/UDP packet headers from %s\n", l.count, path);
+
+    int rc = 0;
+    if (argc > 2) {
+        for (int i = 2; i < argc; i++)
+            rc |= bench_flows(&l, (size_t)strtoull(argv[i], NULL, 10));
+    } else {
+        rc |= bench_flows(&l, 1000000);
+        rc |= bench_flows(&l, 10000000);
+    }
+
+    free(l.pkts);
+    return rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}